@@ -0,0 +1,57 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include "MappedFile.h"
+#include "TranspositionTable.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Search results kept in a memory-mapped file, so they survive restarts and
+// are shared by every Octant process using the same file. Entries are
+// verified like the transposition table's (key ^ data next to data), so
+// processes read and write concurrently without locks.
+//
+// Every open() starts a new generation. When a bucket is full the entry with
+// the lowest depth, less two plies per generation of age, is replaced.
+class AnalysisCache {
+public:
+    AnalysisCache() = default;
+
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+    // Opens or creates 'filename'. A new file is 'megabytes' large; an
+    // existing one keeps the size it was created with. Returns false if the
+    // file cannot be mapped, is not an analysis cache, or holds scores of
+    // another evaluation (Board::EVAL_VERSION).
+    bool open(const std::string& filename, size_t megabytes = 256);
+    void close();
+
+    bool isOpen() const { return buckets != nullptr; }
+    size_t getSizeMB() const { return file.size() >> 20; }
+    const std::string& getFilename() const { return filename; }
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int score, int depth, TTBound bound, uint16_t move);
+
+private:
+    struct Header;
+    struct Slot {
+        uint64_t check; // key ^ data
+        uint64_t data;
+    };
+
+    // One cache line
+    struct Bucket {
+        Slot slots[4];
+    };
+
+    MappedFile file;
+    std::string filename;
+    Bucket* buckets = nullptr;
+    size_t bucketMask = 0;
+    uint32_t generation = 0;
+};
+
+#endif // ANALYSIS_CACHE_H
@@ -0,0 +1,27 @@
+#ifndef BATCH_EVAL_H
+#define BATCH_EVAL_H
+
+#include "DataGen.h"
+#include <cstddef>
+
+// Static evaluation of many positions at once, for scoring datasets rather
+// than searching. Results are the same as Board::evaluateMaterial()
+// (centipawns, White's point of view) without building a Board per position.
+//
+// Positions are taken eight at a time and laid out as structure-of-arrays:
+// slot k of the block holds the k-th piece of each of the eight positions as
+// an index into a (piece, square) weight table, so the weights of a slot are
+// fetched and summed for all eight positions with one AVX2 gather. The AVX2
+// kernel is chosen at run time; other CPUs and compilers use the scalar one.
+class BatchEval {
+public:
+    static void evaluate(const PackedPosition* positions, size_t count, int* scores);
+
+    // Always the portable kernel, for checking and comparing against evaluate()
+    static void evaluateScalar(const PackedPosition* positions, size_t count, int* scores);
+
+    // "avx2" or "scalar", whichever evaluate() uses on this machine
+    static const char* kernelName();
+};
+
+#endif // BATCH_EVAL_H
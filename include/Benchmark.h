@@ -0,0 +1,39 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "Board.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+class Benchmark {
+public:
+    // Counts leaf nodes of the legal move tree to the given depth.
+    static uint64_t perft(Board& board, int depth);
+
+    // Prints per-move leaf counts (perft divide) followed by the total.
+    static uint64_t perftDivide(Board& board, int depth, std::ostream& out);
+
+    // Searches the fixed bench positions and prints the node signature and NPS.
+    static void runBench(int depth, std::ostream& out);
+
+    // Submits 'games' concurrent searches over the bench positions to a
+    // SearchScheduler with 'threads' threads and reports throughput and
+    // latency, next to the same searches run one after another.
+    static void runSchedulerBench(int games, int threads, std::ostream& out);
+
+    // Runs perft throughput, the bench positions and the microbenchmarks and
+    // writes the results as JSON (consumed by perf/check_perf.py).
+    static void runPerfSuite(std::ostream& json);
+
+    // Scores every position of a PackedPosition file through
+    // Board::evaluateMaterial and through both BatchEval kernels, checks that
+    // they agree and reports positions per second
+    static bool runEvalThroughput(const std::string& filename, std::ostream& out);
+
+    // Streams every game of a PGN file and reports games/s and MB/s. With
+    // 'replay' the main line of each game is also decoded and played.
+    static bool runPGNThroughput(const std::string& filename, bool replay, std::ostream& out);
+};
+
+#endif // BENCHMARK_H
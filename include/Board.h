@@ -1,8 +1,11 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <cstdint>
+#include <limits>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 
 enum PieceType {
@@ -40,26 +43,68 @@ struct Move {
         : from(f), to(t), piece(p), capturedPiece(cp), isCastling(castle), isPromotion(promo), promotionPiece(pp) {}
 };
 
+// Squares attacked by each side ([0] White, [1] Black), computed in one
+// pass over the board by Board::getAttacks()
+struct AttackMap {
+    uint64_t occupied[2];
+    uint64_t attacked[2];    // Bit per attacked square
+    uint64_t pawnAttacks[2];
+    uint64_t pieces[2];      // Knights, bishops, rooks and queens
+    int mobility[2][7];      // Attacked squares not holding an own piece, by PieceType
+    int kingZoneAttacks[2];  // Enemy attacks on the king and the squares next to it
+    int kingSquares[2];      // -1 without a king
+    uint64_t pinned;         // Pieces of the side to move pinned against their king
+    uint64_t key;            // Hash of the position the map belongs to
+
+    bool isAttacked(int square, int attackerColor) const {
+        return (attacked[attackerColor == WHITE ? 0 : 1] >> square) & 1;
+    }
+};
+
 class Board {
 public:
     Board();
     ~Board();
 
     void setVerbose(bool verbose);
-    void printBoard() const;
+    void printBoard(std::ostream& out = std::cout) const;
     void setupStandardPosition();
+
+    // FEN (Forsyth-Edwards Notation). setFromFEN parses in place without
+    // allocating and leaves the board untouched if the FEN is invalid.
+    // The move counters are optional.
+    bool setFromFEN(std::string_view fen);
+    std::string toFEN() const;
     
     // Move logic
     bool makeMove(int from, int to); // User friendly wrapper
     bool makeMove(const Move& move); // Engine friendly
     void unmakeMove(const Move& move);
+
+    // Decodes a UCI move ("e2e4", "e7e8q") for the side to move without
+    // generating the move list. Returns a Move with from == -1 unless the move
+    // is pseudo-legal; makeMove still rejects moves that leave the king in check.
+    Move parseUciMove(std::string_view uci) const;
+    // Builds a Move (captured piece, castling, en passant, promotion) for a
+    // pseudo-legal from/to pair; a promotion without a piece promotes to a queen
+    Move buildMove(int from, int to, int promotionPiece) const;
     
     std::vector<Move> generateLegalMoves();
 
     bool isValidMove(int from, int to) const;
     
-    // Evaluation
-    int evaluate() const;
+    // Evaluation, in centipawns from White's point of view: material and
+    // piece-square tables plus mobility, king safety and threats from the
+    // attack map. When material and tables alone are more than a margin
+    // outside (alpha, beta) the attack terms are skipped; the margin is a
+    // heuristic, so such a score can differ from the full evaluation.
+    int evaluate(int alpha = std::numeric_limits<int>::min(), int beta = std::numeric_limits<int>::max()) const;
+    // Bump whenever evaluate() changes; analysis cache files written by
+    // another evaluation are refused
+    static const uint32_t EVAL_VERSION = 1;
+    // Material and piece-square tables only (the terms BatchEval and the tuner
+    // use), updated incrementally by make/unmake
+    int evaluateMaterial() const { return material; }
     
     // Piece specific logic helpers
     bool isPathClear(int from, int to) const;
@@ -67,8 +112,24 @@ public:
     // Getters
     int getPieceAt(int square) const;
     int getTurn() const;
+    int getEnPassantSquare() const { return enPassantSquare; }
+    int getCastlingRights() const { return castlingRights; }
+    int getHalfMoveClock() const { return halfMoveClock; }
+    int getFullMoveNumber() const { return fullMoveNumber; }
+
+    // Zobrist key of the current position, updated incrementally by make/unmake
+    uint64_t getHash() const { return hash; }
+    uint64_t computeHash() const;
     bool isSquareAttacked(int square, int attackerColor) const;
     bool isInCheck(int color) const;
+    // No pawns, rooks or queens and at most one minor piece: neither side can mate
+    bool hasInsufficientMaterial() const;
+
+    // Attack map of the current position. It is computed on the first call
+    // after the position changes and shared by every later query until then:
+    // move generation (legality and castling), check detection and the
+    // evaluation all use the same one.
+    const AttackMap& getAttacks() const;
 
 private:
     int squares[64];
@@ -78,16 +139,29 @@ private:
     // State for special moves
     int enPassantSquare; // -1 if none. Points to the square a pawn can move to for EP capture.
     int castlingRights;  // Bitmask: 1=WK, 2=WQ, 4=BK, 8=BQ
+    int halfMoveClock;   // Plies since the last capture or pawn move
+    int fullMoveNumber;  // Starts at 1, incremented after Black moves
+    uint64_t hash;
+    int material; // See evaluateMaterial()
+    uint64_t occupancy; // Bit per occupied square, updated by make/unmake
     
     // History for unmake
     struct GameState {
         int enPassantSquare;
         int castlingRights;
         int capturedPiece;
-        int halfMoveClock; // For 50 move rule (TODO)
+        int halfMoveClock;
+        uint64_t hash;
+        int material;
+        uint64_t occupancy;
     };
     std::vector<GameState> history;
 
+    mutable AttackMap attacks; // Valid while attacks.key == hash
+    void computeAttacks(AttackMap& map) const;
+    int computeMaterial() const;
+    uint64_t computeOccupancy() const;
+
     // Internal helpers
     void log(const std::string& message) const;
     bool validatePawnMove(int from, int to, int piece, int target) const;
@@ -97,7 +171,7 @@ private:
     void generateKnightMoves(int square, std::vector<Move>& moves) const;
     void generateSlidingMoves(int square, std::vector<Move>& moves, const int directions[][2], int numDirs) const;
     void generateKingMoves(int square, std::vector<Move>& moves) const;
-    
+
     // Low level move execution without validation (for makeMove/unmakeMove)
     void applyMove(const Move& move);
     void undoApplyMove(const Move& move);
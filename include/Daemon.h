@@ -0,0 +1,68 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "AnalysisCache.h"
+#include "TranspositionTable.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct DaemonOptions {
+    std::string socketPath = "/tmp/octant.sock";
+    int workers = 0;          // Search threads, 0 = one per hardware thread
+    size_t hashMB = 64;       // Transposition table shared by every session
+    size_t queueLimit = 64;   // Commands waiting across all sessions before "error busy"
+    int sessionTimeout = 600; // Seconds an idle session is kept
+    std::string cacheFile;    // Analysis cache shared by every session, empty = none
+    size_t cacheMB = 256;     // Size of a newly created cache file
+};
+
+// Serves many UCI sessions over a local Unix socket.
+//
+// Protocol: one command per line, prefixed with a session id chosen by the
+// client ("<session> <uci command>"). Each session has its own board and
+// search and runs its commands in order on one of the worker threads; every
+// line of output comes back prefixed with the same id. "<session> close"
+// discards a session and "<session> stop" interrupts its search without
+// waiting in the queue. When the queue is full a command is rejected with
+// "<session> error busy" instead of waiting.
+class Daemon {
+public:
+    explicit Daemon(const DaemonOptions& options);
+    ~Daemon();
+
+    Daemon(const Daemon&) = delete;
+    Daemon& operator=(const Daemon&) = delete;
+
+    // Listens until SIGINT or SIGTERM. Returns a process exit code.
+    int run();
+
+private:
+    struct Connection;
+    struct Session;
+
+    DaemonOptions options;
+    std::shared_ptr<TranspositionTable> table;
+    std::shared_ptr<AnalysisCache> cache;
+
+    // Sessions with pending commands, each listed at most once
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::shared_ptr<Session>> readyQueue;
+    size_t pendingCommands;
+    bool stopping;
+
+    std::vector<std::thread> workers;
+
+    void workerLoop();
+    void dispatch(const std::shared_ptr<Connection>& connection, const std::string& line);
+    void dropPending(Connection& connection);
+    void evictIdleSessions(Connection& connection);
+};
+
+#endif // DAEMON_H
@@ -0,0 +1,59 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include "Board.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// One training position in 32 bytes. Pieces are listed in square order
+// (a1 = 0) as nibbles, one per set bit of 'occupancy': the piece type in the
+// low three bits and 8 for Black. Files of these records have no header, so
+// they can be concatenated, memory-mapped and shuffled in place.
+struct PackedPosition {
+    uint64_t occupancy;
+    uint8_t pieces[16];
+    int16_t score;           // Search score in centipawns, White's point of view
+    uint8_t result;          // 0 Black won, 1 draw, 2 White won
+    uint8_t flags;           // Bit 0: Black to move; bits 1-4: castling rights
+    uint8_t enPassant;       // Square, 64 if none
+    uint8_t halfMoveClock;
+    uint16_t fullMoveNumber;
+
+    static PackedPosition pack(const Board& board, int score, int result);
+
+    // Sets up 'board' from the record. Returns false if it is invalid.
+    bool unpack(Board& board) const;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+struct DataGenOptions {
+    uint64_t positions = 1000000; // Stop once this many are written
+    int threads = 0;              // 0 = one per hardware thread
+    uint64_t nodes = 5000;        // Per move
+    int depth = 0;                // Per move, 0 = no depth limit
+    int randomPlies = 8;          // Random moves that start every game
+    int maxPlies = 400;           // Longer games are drawn
+    int minPly = 16;              // Earlier positions are not written
+    int resignScore = 1500;       // Adjudicated once both engines agree for resignMoves moves each
+    int resignMoves = 3;
+    size_t hashMB = 16;           // Per thread
+    uint64_t seed = 0;            // 0 = from the clock
+};
+
+// Self-play training data. Every thread plays games from random openings at
+// a fixed node count and keeps the quiet positions (side to move not in
+// check, best move neither a capture nor a promotion, no mate score) with
+// the search score and the game result.
+class DataGen {
+public:
+    // Appends PackedPosition records to 'filename'. Progress goes to 'log'.
+    static bool run(const DataGenOptions& options, const std::string& filename, std::ostream& log);
+
+    // Shuffles the records of 'filename' in place
+    static bool shuffle(const std::string& filename, uint64_t seed, std::ostream& log);
+};
+
+#endif // DATAGEN_H
@@ -0,0 +1,64 @@
+#ifndef EPDSUITE_H
+#define EPDSUITE_H
+
+#include "Board.h"
+#include "Search.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One line of an EPD file: four FEN fields followed by operations
+// ("bm Nf3 Qxe5;", "am Bxh7;", "id \"WAC.001\";", "acd 8;")
+struct EPDPosition {
+    std::string fen;
+    std::string id;
+    std::vector<Move> bestMoves;  // bm
+    std::vector<Move> avoidMoves; // am
+    int depth = 0;                // acd, 0 if absent
+    std::string result;           // c9 ("1-0", "0-1", "1/2-1/2"), empty if absent
+    int line = 0;                 // Line number in the file
+};
+
+struct EPDOptions {
+    SearchLimits limits;      // Per position; acd overrides the depth unless depthGiven
+    bool depthGiven = false;
+    int threads = 0;          // 0 = one per hardware thread
+    size_t hashMB = 16;       // Transposition table of each worker
+};
+
+struct EPDResult {
+    Move move;
+    bool solved = false;
+    int depth = 0;            // Last completed iteration
+    int score = 0;            // Centipawns, side to move's point of view
+    uint64_t nodes = 0;
+    double milliseconds = 0;
+};
+
+class EPDSuite {
+public:
+    // Parses one line. Returns false for blank lines, comments ("#") and
+    // lines whose position or moves are invalid.
+    static bool parse(std::string_view line, EPDPosition& position);
+
+    // Reads every valid position; invalid lines are reported to 'log'
+    bool load(const std::string& filename, std::ostream& log);
+
+    const std::vector<EPDPosition>& getPositions() const { return positions; }
+
+    // Searches every position on a pool of workers, each with its own
+    // Search and transposition table. Prints a line per position as it
+    // finishes and a summary at the end. Results are in file order.
+    std::vector<EPDResult> run(const EPDOptions& options, std::ostream& out) const;
+
+    void writeJSON(const std::vector<EPDResult>& results, const EPDOptions& options,
+                   double seconds, std::ostream& json) const;
+
+private:
+    std::string filename;
+    std::vector<EPDPosition> positions;
+};
+
+#endif // EPDSUITE_H
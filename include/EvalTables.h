@@ -0,0 +1,14 @@
+#ifndef EVAL_TABLES_H
+#define EVAL_TABLES_H
+
+// Evaluation weights in centipawns, defined in src/EvalTables.cpp so that
+// the tuner (--tune) can write a replacement file.
+
+// Material, indexed by PieceType
+extern const int pieceValues[7];
+
+// Piece-square tables indexed by PieceType and square (a1 = 0) from White's
+// side; Black's pieces use the square mirrored by rank (square ^ 56)
+extern const int pieceSquareTables[7][64];
+
+#endif // EVAL_TABLES_H
@@ -0,0 +1,27 @@
+#ifndef LINESTREAM_H
+#define LINESTREAM_H
+
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+// Stream buffer that hands every complete line (without the '\n') to a
+// callback. Lets code that writes to a std::ostream, like UCI, send its
+// output somewhere other than stdout.
+class LineStreamBuf : public std::streambuf {
+public:
+    using LineCallback = std::function<void(std::string_view)>;
+
+    explicit LineStreamBuf(LineCallback callback) : callback(std::move(callback)) {}
+
+protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+private:
+    LineCallback callback;
+    std::string line;
+};
+
+#endif // LINESTREAM_H
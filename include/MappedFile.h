@@ -0,0 +1,45 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// View of a whole file. open() maps it read-only (reading the file into memory
+// where mmap is unavailable); openShared() maps it writable and shared with
+// every other process mapping the same file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened. Empty files open successfully.
+    bool open(const std::string& filename);
+    void close();
+
+    // Creates 'filename' with 'size' zero bytes if it is missing or empty and
+    // maps it read-write. An existing file keeps its size, whatever 'size'
+    // says. Returns false where shared mappings are not supported.
+    bool openShared(const std::string& filename, size_t size);
+
+    // Schedules modified pages of a shared mapping to be written back
+    void flush();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+    char* writableData() { return writable ? const_cast<char*>(ptr) : nullptr; }
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+    bool opened = false;
+    bool mapped = false;
+    bool writable = false;
+    std::vector<char> buffer; // Fallback storage when mmap is unavailable
+};
+
+#endif // MAPPEDFILE_H
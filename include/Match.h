@@ -0,0 +1,100 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "Search.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One side of a match. With a clock (timeMs > 0) every move gets a share of
+// the remaining time plus most of the increment; otherwise 'limits' applies
+// to each move.
+struct MatchEngine {
+    std::string name;
+    SearchLimits limits;
+    int64_t timeMs = 0;      // Clock per game, 0 = per-move limits only
+    int64_t incrementMs = 0;
+    size_t hashMB = 16;
+
+    // Applies "key=value,..." settings: name, depth, nodes, movetime, hash,
+    // tc=SECONDS[+INCREMENT]. Returns false on an unknown key or bad value.
+    bool configure(std::string_view spec);
+};
+
+struct MatchOptions {
+    MatchEngine engines[2];
+    std::vector<std::string> openings; // FENs, each played twice with colors reversed
+    int games = 0;                     // 0 = two per opening
+    int threads = 0;                   // 0 = one per hardware thread
+    int maxPlies = 400;                // Longer games are drawn
+    std::string pgnFile;               // Empty = no PGN
+
+    // Adjudication; scores in centipawns from the reporting engine's side
+    int resignScore = 1000;  // Game over when both engines agree for resignMoves moves each
+    int resignMoves = 3;
+    int drawScore = 10;      // Drawn when both engines are within drawScore for drawMoves moves each
+    int drawMoves = 8;
+    int drawMinPly = 80;     // Draw adjudication is not applied before this ply
+
+    // SPRT on the Elo of engines[0] against engines[1]
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+    bool sprt = false;       // Stop as soon as a bound is crossed
+};
+
+// Resign adjudication on the engines' own scores, converted to White's view:
+// a side loses once every score of its last 'moves' moves and its opponent's
+// is at least 'score' against it
+class ResignAdjudicator {
+public:
+    ResignAdjudicator(int score, int moves) : score(score), moves(moves) {}
+
+    // Records the score of the move just searched. Returns 1 if White wins,
+    // -1 if Black wins and 0 while the game goes on.
+    int update(int whiteScore);
+
+private:
+    int score;
+    int moves;
+    int streak = 0; // Consecutive plies past 'score', signed by the winning side
+};
+
+// Wins, draws and losses of engines[0] with the usual estimates
+struct MatchScore {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const;     // Points per game, 0.5 with no games
+
+    // Elo difference and the half width of its 95% confidence interval
+    double elo() const;
+    double eloError() const;
+
+    // Log-likelihood ratio of H1 (elo1) against H0 (elo0), using the
+    // normal approximation of the trinomial score distribution
+    double llr(double elo0, double elo1) const;
+};
+
+class Match {
+public:
+    // Reads FENs or EPD positions, one per line ('#' comments). Returns false
+    // if the file cannot be read.
+    static bool loadOpenings(const std::string& filename, std::vector<std::string>& openings, std::ostream& log);
+
+    // Positions after each pair of first moves from the start position (400)
+    static std::vector<std::string> defaultOpenings();
+
+    // Plays the games on a pool of threads, each game with its own Boards
+    // and Searches. Prints every result with the running score, Elo and
+    // LLR, and a summary at the end.
+    static MatchScore run(const MatchOptions& options, std::ostream& out);
+};
+
+#endif // MATCH_H
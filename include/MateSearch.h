@@ -0,0 +1,85 @@
+#ifndef MATE_SEARCH_H
+#define MATE_SEARCH_H
+
+#include "Board.h"
+#include "Search.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct MateResult {
+    int moves = 0;         // Mate in this many moves, 0 if none was proven
+    std::vector<Move> pv;  // Mating line, ending in mate
+    uint64_t nodes = 0;
+    int64_t milliseconds = 0;
+};
+
+// Mate solver for "go mate N": depth-first proof-number search (df-pn).
+//
+// The side to move is the attacker. Its nodes are proven by one mating move
+// and the defender's by every reply being mated, so the search always
+// expands the branch that is cheapest to prove or disprove instead of
+// searching every move to full depth. Proof and disproof numbers are kept in
+// the solver's own hash table, keyed by position and remaining depth. Mates
+// in 1, 2, ... N are tried in turn, so the first one proven is the shortest.
+// On the attacker's last move only checks are generated. Repetitions are not
+// scored as draws: a result that depends on the path to a position cannot be
+// stored in a table shared by every path, and the depth bound ends each line.
+class MateSearch {
+public:
+    // The table is allocated by the first solve()
+    explicit MateSearch(size_t megabytes = 16);
+
+    // Looks for a mate in at most 'maxMoves' moves, within the node and time
+    // limits of 'limits' (its depth is ignored). Writes UCI info lines.
+    // Returns false if no mate was proven.
+    bool solve(Board& board, int maxMoves, const SearchLimits& limits, MateResult& result);
+
+    // Same protocol as Search::stop() and Search::clearStop()
+    void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+    void clearStop() { stopRequested.store(false, std::memory_order_relaxed); }
+
+    void setOutput(std::ostream& stream) { out = &stream; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t pn;
+        uint32_t dn;
+    };
+
+    // Four entries per cache line; proven and disproven entries are kept
+    // over ones still being searched
+    struct Bucket {
+        Entry entries[4];
+    };
+
+    struct Child {
+        Move move;
+        uint64_t key;
+        uint64_t hash;
+        bool check;
+    };
+
+    bool lookup(uint64_t key, uint32_t& pn, uint32_t& dn) const;
+    void store(uint64_t key, uint32_t pn, uint32_t dn);
+
+    void children(Board& board, int remaining, bool attacker, std::vector<Child>& list);
+    void mid(Board& board, uint64_t key, int remaining, bool attacker, uint32_t thresholdPn, uint32_t thresholdDn);
+    void principalVariation(Board& board, int remaining, std::vector<Move>& pv);
+    bool limitReached() const;
+
+    size_t sizeMB;
+    std::vector<Bucket> table;
+    uint64_t nodes = 0;
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<bool> stopRequested{false};
+    bool aborted = false;
+    std::ostream* out;
+};
+
+#endif // MATE_SEARCH_H
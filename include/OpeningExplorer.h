@@ -0,0 +1,74 @@
+#ifndef OPENING_EXPLORER_H
+#define OPENING_EXPLORER_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct ExplorerMove {
+    Move move;
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+    uint32_t blackWins = 0;
+
+    uint32_t games() const { return whiteWins + draws + blackWins; }
+};
+
+struct ExplorerBuildOptions {
+    int threads = 0;       // 0 = one per hardware thread
+    int maxPly = 40;       // Positions deeper into a game are not indexed
+    uint32_t minGames = 1; // Moves played fewer times are dropped
+};
+
+// Per-position move statistics from a PGN collection.
+//
+// The index is a file of fixed-size records (Zobrist key, move, white wins,
+// draws, black wins) sorted by key, so a query is a binary search in the
+// memory-mapped file. Keys are Board::getHash(); an index built by an
+// engine with different Zobrist keys is refused.
+class OpeningExplorer {
+public:
+    OpeningExplorer() = default;
+
+    OpeningExplorer(const OpeningExplorer&) = delete;
+    OpeningExplorer& operator=(const OpeningExplorer&) = delete;
+
+    // Replays the main line of every decisive or drawn game in 'pgnFiles' on
+    // several threads and writes the index. Progress and errors go to 'log'.
+    static bool build(const std::vector<std::string>& pgnFiles, const std::string& indexFile,
+                      const ExplorerBuildOptions& options, std::ostream& log);
+
+    bool open(const std::string& indexFile);
+    void close();
+
+    bool isOpen() const { return records != nullptr; }
+    uint64_t getGameCount() const { return gameCount; }
+    size_t getRecordCount() const { return recordCount; }
+
+    // Moves played from the position, most played first. Returns the number
+    // of moves found; 'moves' is cleared first.
+    size_t query(Board& board, std::vector<ExplorerMove>& moves) const;
+
+    // Picks a move the way an opening book would: the most played one with
+    // 'best', otherwise at random in proportion to how often each was played.
+    // Move() (from == -1) if the position is not in the index.
+    Move bookMove(Board& board, bool best);
+
+    // Prints the query result as a table with SAN moves and percentages
+    static void print(Board& board, const std::vector<ExplorerMove>& moves, std::ostream& out);
+
+private:
+    struct Record;
+
+    MappedFile file;
+    const Record* records = nullptr;
+    size_t recordCount = 0;
+    uint64_t gameCount = 0;
+    uint64_t randomState = 0;
+};
+
+#endif // OPENING_EXPLORER_H
@@ -3,6 +3,7 @@
 
 #include "Board.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 class PGNLoader {
@@ -14,6 +15,14 @@ public:
     // Parses a single SAN move string (e.g., "Nf3") and returns the corresponding Move object.
     // Returns an empty/invalid Move if parsing fails.
     static Move parseSAN(const std::string& san, Board& board);
+
+    // Same as above without copying the token. Candidate moves are found by
+    // looking outward from the target square, not by generating all legal moves.
+    static Move parseSAN(std::string_view san, Board& board);
+
+    // Formats a legal move in SAN, including disambiguation and the check/mate
+    // suffix. Legal moves are only enumerated to tell mate from check.
+    static std::string toSAN(const Move& move, Board& board);
 };
 
 #endif // PGNLOADER_H
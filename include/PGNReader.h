@@ -0,0 +1,81 @@
+#ifndef PGNREADER_H
+#define PGNREADER_H
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Zero-copy PGN parsing. Every string_view points into the mapped file and
+// stays valid until the PGNReader is closed or reopened.
+
+struct PGNTag {
+    std::string_view name;
+    std::string_view value; // Without the surrounding quotes; escapes are left as-is
+};
+
+struct PGNGame {
+    std::vector<PGNTag> tags;   // Reused between games, so steady-state reading does not allocate
+    std::string_view movetext;  // Everything after the tag pairs, including the result
+    std::string_view result;    // "1-0", "0-1", "1/2-1/2", "*" or empty if missing
+    size_t offset = 0;          // Byte offset of the game in the file
+
+    // Returns the value of the named tag, or an empty view
+    std::string_view tag(std::string_view name) const;
+};
+
+enum PGNTokenType {
+    PGN_MOVE,            // SAN move; annotation glyphs such as "!?" are split off into 'annotation'
+    PGN_COMMENT,         // "{...}" or ";..." comment, text without the delimiters
+    PGN_NAG,             // "$n", text without the '$'
+    PGN_VARIATION_START, // "("
+    PGN_VARIATION_END,   // ")"
+    PGN_RESULT           // Game termination marker
+};
+
+struct PGNToken {
+    PGNTokenType type;
+    std::string_view text;
+    std::string_view annotation; // Trailing "!", "?", "!!", "!?", "?!", "??" on moves
+    int depth;                   // Variation nesting; 0 is the main line
+};
+
+// Iterates over the tokens of a movetext section. Move numbers are skipped.
+class PGNTokenizer {
+public:
+    explicit PGNTokenizer(std::string_view movetext) : text(movetext) {}
+
+    // Returns false at the end of the movetext
+    bool next(PGNToken& token);
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+    int depth = 0;
+};
+
+// Streams games one at a time from a memory-mapped PGN file.
+class PGNReader {
+public:
+    bool open(const std::string& filename);
+    void close();
+
+    // Reads the next game. Returns false at the end of the file.
+    bool next(PGNGame& game);
+
+    size_t bytesRead() const { return pos; }
+    size_t size() const { return file.size(); }
+
+private:
+    MappedFile file;
+    size_t pos = 0;
+
+    void skipWhitespaceAndEscapes();
+    bool readTag(PGNTag& tag);
+};
+
+// True for "1-0", "0-1", "1/2-1/2" and "*"
+bool isPGNResult(std::string_view token);
+
+#endif // PGNREADER_H
@@ -0,0 +1,46 @@
+#ifndef POLYGLOT_BOOK_H
+#define POLYGLOT_BOOK_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opening book in the Polyglot .bin format: 16-byte big-endian entries
+// (key, move, weight, learn) sorted by key. The file is memory-mapped and
+// probed with a binary search; a probe does not allocate.
+//
+// Polyglot keys use the 781 Random64 constants of the Polyglot format from
+// data/polyglot_random64.inc; the build checks them against the start
+// position key of the specification.
+class PolyglotBook {
+public:
+    PolyglotBook() = default;
+
+    PolyglotBook(const PolyglotBook&) = delete;
+    PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+    // Polyglot key of the position
+    static uint64_t key(const Board& board);
+
+    // Returns false if the file is not a Polyglot book
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return count > 0; }
+    size_t size() const { return count; }
+
+    // A legal book move for the position, or Move() (from == -1) if there is
+    // none. With 'best' the highest weight wins, otherwise moves are picked
+    // at random in proportion to their weight.
+    Move probe(Board& board, bool best);
+
+private:
+    MappedFile file;
+    const unsigned char* entries = nullptr;
+    size_t count = 0;
+    uint64_t randomState = 0;
+};
+
+#endif // POLYGLOT_BOOK_H
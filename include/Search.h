@@ -1,22 +1,212 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include "AnalysisCache.h"
 #include "Board.h"
+#include "SearchTrace.h"
+#include "Tablebase.h"
+#include "Task.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Hot-path counters are compiled in only with -DOCTANT_SEARCH_STATS
+// (cmake -DOCTANT_SEARCH_STATS=ON); otherwise SEARCH_STAT expands to nothing.
+#ifdef OCTANT_SEARCH_STATS
+#define SEARCH_STAT(expr) (expr)
+#else
+#define SEARCH_STAT(expr) ((void)0)
+#endif
+
+struct SearchStats {
+    struct Iteration {
+        int depth;
+        uint64_t nodes;
+        double milliseconds;
+    };
+
+    uint64_t nodes = 0;            // All alphaBeta calls
+    uint64_t leafNodes = 0;        // Static evaluations at the horizon
+    uint64_t cutoffs = 0;          // Alpha/beta cutoffs
+    uint64_t firstMoveCutoffs = 0; // Cutoffs produced by the first move searched
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    uint64_t ttCutoffs = 0;        // Nodes answered from the transposition table
+    uint64_t cacheProbes = 0;
+    uint64_t cacheHits = 0;
+    uint64_t cacheCutoffs = 0;     // Nodes answered from the analysis cache
+    std::vector<Iteration> iterations;
+
+    void clear() { *this = SearchStats(); }
+
+    // Writes the counters as UCI "info string" lines
+    void print(std::ostream& out) const;
+};
+
+struct SearchLimits {
+    static const int MAX_DEPTH = 64;
+
+    int depth = 4;        // Deepest iteration
+    int64_t movetime = 0; // Milliseconds, 0 = no limit
+    uint64_t nodes = 0;   // 0 = no limit
+    int multiPV = 1;      // Best root moves searched exactly and reported (findBestMove only)
+    bool ponder = false;  // Started with Search::startPondering(); no limits until ponderhit()
+};
+
+// Result of one completed iteration, as printed in the UCI "info" line
+struct SearchInfo {
+    int depth = 0;
+    int score = 0;      // Centipawns from the side to move's point of view
+    int mate = 0;       // Moves to mate when non-zero (negative: getting mated)
+    int multipv = 1;    // Rank of the line among the root moves
+    uint64_t nodes = 0;
+    uint64_t nps = 0;
+    int64_t milliseconds = 0;
+    std::vector<Move> pv;
+};
+
+// State of a cooperative search (Search::findBestMoveCooperative) shared
+// with whoever drives it, normally SearchScheduler
+struct SearchSlice {
+    std::coroutine_handle<> resumePoint; // Where the search continues after a yield
+    uint64_t nodesPerSlice = 2048;       // Nodes searched between yields
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // Filled in by the search
+    uint64_t nextYield = 0;
+    bool timedOut = false;  // Deadline passed; the result is from completedDepth
+    int completedDepth = 0;
+    int score = 0;
+};
 
 class Search {
 public:
     Search();
     ~Search();
 
-    // Find the best move for the current side to move
+    // Find the best move for the current side to move.
+    // Searches iteratively from depth 1 up to 'depth'.
     Move findBestMove(Board& board, int depth);
 
+    // Same, stopping at whichever limit comes first or at stop(). An
+    // unfinished iteration is discarded. Prints a UCI "info" line with the
+    // principal variation after every completed iteration.
+    Move findBestMove(Board& board, const SearchLimits& limits);
+
+    // Makes a running findBestMove return as soon as possible. Safe to call
+    // from another thread. The request stays set until clearStop(), so a stop
+    // that arrives just before the search starts is not lost.
+    void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+    // Also ends pondering, so a stopped ponder search leaves nothing behind
+    void clearStop() {
+        stopRequested.store(false, std::memory_order_relaxed);
+        pondering.store(false, std::memory_order_release);
+    }
+
+    // Makes the next findBestMove ignore its limits until ponderhit(). Call it
+    // before the search thread starts: findBestMove does not touch the state,
+    // so a ponderhit() that arrives before the search begins still counts.
+    void startPondering() { pondering.store(true, std::memory_order_release); }
+    // Turns a ponder search into a normal one, with its time limit counted
+    // from now. The tree searched so far is kept: the search simply goes on.
+    // Safe to call from another thread.
+    void ponderhit();
+    bool isPondering() const { return pondering.load(std::memory_order_acquire); }
+    // Returns once the search is no longer pondering or a stop was requested.
+    // A ponder search that finishes early must wait before it answers.
+    void waitForPonderhit() const;
+
+    // Same search as findBestMove, but suspends every slice.nodesPerSlice
+    // nodes and stops at slice.deadline with the best move of the last
+    // completed iteration. Prints nothing.
+    Task<Move> findBestMoveCooperative(Board& board, int depth, SearchSlice& slice);
+
+    // Nodes visited by the last call to findBestMove
+    uint64_t getNodesVisited() const { return nodesVisited; }
+
+    // Counters of the last search (empty unless built with OCTANT_SEARCH_STATS)
+    const SearchStats& getStats() const { return stats; }
+
+    // Records every searched node to 'filename' (see SearchTrace.h).
+    // An empty filename disables tracing. Returns false if the file cannot be opened.
+    bool setTraceFile(const std::string& filename);
+
+    // The table is created on first use; several Search objects may share one.
+    std::shared_ptr<TranspositionTable> getTranspositionTable();
+    void setTranspositionTable(std::shared_ptr<TranspositionTable> table) { tt = std::move(table); }
+
+    // Persistent results (see AnalysisCache.h) read and written at the root
+    // and in the first plies. Several Search objects may share one.
+    void setAnalysisCache(std::shared_ptr<AnalysisCache> cache) { analysisCache = std::move(cache); }
+
+    // Endgame tables probed in the search when set; root positions covered
+    // by them are played from the tables without searching.
+    void setTablebases(std::shared_ptr<const Tablebases> tables) { tablebases = std::move(tables); }
+
+    // Where progress messages are written (std::cout by default)
+    void setOutput(std::ostream& stream) { out = &stream; }
+
+    // Called after every completed iteration of findBestMove, on the searching thread
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback) { infoCallback = std::move(callback); }
+
 private:
+    // Searches every root move to 'depth' and returns the best one
+    Move searchRoot(Board& board, std::vector<Move>& moves, int depth, int& bestValue);
+    // Best 'lines' root moves, one root search per line over the moves not
+    // chosen yet. Moves them to the front of 'moves' in order and sets their
+    // values.
+    void searchRootLines(Board& board, std::vector<Move>& moves, int depth, int lines, std::vector<int>& values);
+
+    // Checked every 1024 nodes; sets 'aborted'
+    bool limitReached() const;
+
+    // Moves stored in the transposition table from the root, starting with 'first'
+    std::vector<Move> principalVariation(Board& board, const Move& first, int maxLength);
+    // 'multipv' is printed when non-zero
+    void printInfo(Board& board, int depth, int value, const Move& bestMove, int multipv = 0);
+
     // Alpha-Beta Pruning recursive search
-    int alphaBeta(Board& board, int depth, int alpha, int beta, bool maximizingPlayer);
+    int alphaBeta(Board& board, int depth, int ply, int alpha, int beta, bool maximizingPlayer);
+    Task<int> alphaBetaCooperative(Board& board, int depth, int ply, int alpha, int beta, bool maximizingPlayer, SearchSlice& slice);
+
+    // Transposition table helpers shared by both searches; near the root they
+    // also use the analysis cache. probeTable returns true with 'value' set
+    // when a stored result answers the node.
+    bool probeTable(uint64_t key, int depth, int ply, int alpha, int beta, int& value, uint16_t& ttMove);
+    void storeTable(uint64_t key, int depth, int ply, int alphaIn, int betaIn, int value, const Move& bestMove);
+
+    // Tablebase score of the node as a mate score for 'depth', or 0 for a
+    // draw. Returns false if the position is not in the tables.
+    bool probeTablebase(const Board& board, int depth, int& value) const;
+    // Best root move by the tables: fastest win, draw, or slowest loss
+    bool tablebaseMove(Board& board, const std::vector<Move>& moves, Move& bestMove, int& bestValue) const;
     
     // Stats
-    int nodesVisited;
+    uint64_t nodesVisited;
+    SearchStats stats;
+
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<int64_t> timerStart; // Time limits count from here (steady_clock ticks)
+    std::atomic<bool> pondering;
+    std::atomic<bool> stopRequested;
+    bool aborted;
+
+    std::shared_ptr<TranspositionTable> tt;
+    std::shared_ptr<AnalysisCache> analysisCache;
+    std::shared_ptr<const Tablebases> tablebases;
+    std::ostream* out;
+    std::function<void(const SearchInfo&)> infoCallback;
+
+    // Null unless tracing is enabled
+    std::unique_ptr<SearchTracer> tracer;
 };
 
 #endif // SEARCH_H
@@ -0,0 +1,75 @@
+#ifndef SEARCH_SCHEDULER_H
+#define SEARCH_SCHEDULER_H
+
+#include "Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+struct ScheduledSearch {
+    int depth = 4;
+    int priority = 0;                       // Higher runs first
+    std::chrono::milliseconds timeLimit{0}; // 0 = no deadline
+};
+
+struct ScheduledResult {
+    Move bestMove;
+    int score = 0;
+    int depth = 0;         // Last completed iteration
+    uint64_t nodes = 0;
+    bool timedOut = false;
+    double milliseconds = 0; // From submit to result, including time spent waiting
+};
+
+// Runs many searches on a small fixed pool of threads. Each search is a
+// coroutine (Search::findBestMoveCooperative) that yields every
+// nodesPerSlice nodes; the scheduler then resumes the highest-priority
+// waiting search, round-robin among equal priorities. A search costs its own
+// Board and coroutine frames rather than a thread.
+class SearchScheduler {
+public:
+    // threads == 0 uses one thread per hardware thread. All searches share
+    // 'table'; a 16 MB table is created when it is null.
+    explicit SearchScheduler(int threads = 0, std::shared_ptr<TranspositionTable> table = nullptr,
+                             uint64_t nodesPerSlice = 2048);
+
+    // Finishes every submitted search before returning
+    ~SearchScheduler();
+
+    SearchScheduler(const SearchScheduler&) = delete;
+    SearchScheduler& operator=(const SearchScheduler&) = delete;
+
+    std::future<ScheduledResult> submit(const Board& board, const ScheduledSearch& options);
+
+    int getThreadCount() const { return (int)workers.size(); }
+
+private:
+    struct Job;
+    struct JobOrder {
+        bool operator()(const Job* a, const Job* b) const;
+    };
+
+    std::shared_ptr<TranspositionTable> table;
+    uint64_t nodesPerSlice;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::priority_queue<Job*, std::vector<Job*>, JobOrder> queue;
+    uint64_t sequence;  // Orders jobs of equal priority, bumped on every requeue
+    size_t unfinished;  // Submitted jobs that have not completed
+    bool stopping;
+
+    std::vector<std::thread> workers;
+
+    void workerLoop();
+};
+
+#endif // SEARCH_SCHEDULER_H
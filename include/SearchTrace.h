@@ -0,0 +1,96 @@
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Binary search-tree trace.
+//
+// File layout: a TraceHeader followed by TraceEvents in post-order (a node's
+// event is written after the events of its children). Events at ply p + 1
+// written since the last event at ply <= p are the children of the next event
+// at ply p. Read with tools/octant_trace.cpp.
+
+const char TRACE_MAGIC[8] = {'O', 'C', 'T', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t TRACE_VERSION = 1;
+const uint16_t TRACE_NO_CUTOFF = 0xFFFF;
+
+enum TraceEventType : uint8_t {
+    TRACE_NODE = 0,      // One searched node
+    TRACE_ITERATION = 1, // Start of an iterative deepening iteration (depth in 'depth')
+};
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t eventSize;
+};
+
+struct TraceEvent {
+    uint32_t node;        // Node counter at entry (pre-order id)
+    uint32_t subtree;     // Nodes in this subtree, including the node itself
+    int32_t alpha;        // Window at entry
+    int32_t beta;
+    int32_t score;
+    uint16_t move;        // Move leading to the node: from | to << 6 | promotion << 12
+    uint8_t ply;
+    uint8_t type;         // TraceEventType
+    uint16_t cutoffIndex; // Index of the move that caused a cutoff, or TRACE_NO_CUTOFF
+    uint16_t depth;       // Remaining depth
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TraceEvent) == 32, "TraceEvent must stay 32 bytes");
+
+inline uint16_t packTraceMove(int from, int to, int promotionPiece) {
+    return (uint16_t)(from | (to << 6) | (promotionPiece << 12));
+}
+
+// Per-search ring buffer of trace events. The buffer is allocated once and
+// written to the file whenever it fills up and when the search ends, so
+// recording an event never allocates.
+class SearchTracer {
+public:
+    static const int MAX_PLY = 128;
+
+    // Opens (truncates) 'filename'. Returns false if it cannot be written.
+    bool open(const std::string& filename, size_t capacity = 1 << 16);
+    void close();
+    bool isOpen() const { return file.is_open(); }
+
+    // Writes buffered events to the file
+    void flush();
+
+    void beginIteration(int depth, uint64_t node);
+
+    // Remembers the move being searched at 'ply' so the child's event can carry it
+    void setMove(int ply, uint16_t move) { path[ply & (MAX_PLY - 1)] = move; }
+
+    void record(int ply, int depth, int alpha, int beta, int score, int cutoffIndex,
+                uint64_t node, uint64_t subtree) {
+        TraceEvent& e = buffer[count];
+        // The file keeps 32-bit node numbers; they wrap on very long searches
+        e.node = (uint32_t)node;
+        e.subtree = (uint32_t)subtree;
+        e.alpha = alpha;
+        e.beta = beta;
+        e.score = score;
+        e.move = path[ply & (MAX_PLY - 1)];
+        e.ply = (uint8_t)ply;
+        e.type = TRACE_NODE;
+        e.cutoffIndex = cutoffIndex < 0 ? TRACE_NO_CUTOFF : (uint16_t)cutoffIndex;
+        e.depth = (uint16_t)depth;
+        e.reserved = 0;
+        if (++count == buffer.size()) flush();
+    }
+
+private:
+    std::ofstream file;
+    std::vector<TraceEvent> buffer;
+    size_t count = 0;
+    uint16_t path[MAX_PLY] = {};
+};
+
+#endif // SEARCHTRACE_H
@@ -0,0 +1,69 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "Board.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TablebasePosition; // Piece list, see Tablebase.cpp
+
+struct TablebaseResult {
+    int wdl = 0;   // 1 if the side to move wins, 0 for a draw, -1 if it loses
+    int plies = 0; // Until mate with best play by both sides (0 = checkmated)
+};
+
+// Endgame tablebases for every material with at most four pieces, kings
+// included, built here by retrograde analysis.
+//
+// Each table (one file per material, named like "KQKR.otb") stores one byte
+// per position: draw, or win or loss for the side to move with the distance
+// to mate. The stronger side is always White in the table; positions with
+// colors the other way round are probed mirrored. Pawnless tables keep the
+// white king in the a1-d1-d4 triangle (eight symmetries), tables with pawns
+// on files a-d (left-right mirror). Castling and en passant are not in the
+// tables, so positions with castling rights or an en passant square are not
+// probed; a double push the opponent can take en passant is scored with the
+// capture when the tables are built.
+class Tablebases {
+public:
+    Tablebases();
+    ~Tablebases();
+
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    // Maps every table file in 'directory'. Returns false if there is none.
+    bool open(const std::string& directory);
+    size_t getTableCount() const { return tables.size(); }
+
+    // Returns false if the position is not in a loaded table
+    bool probe(const Board& board, TablebaseResult& result) const;
+
+    // Generates the tables 'names' ("KRK", "KQKP", ...; all of them if
+    // empty) into 'directory' along with the smaller tables they need.
+    // Files already there are used as they are. The positions of each table
+    // are first scored on 'threads' threads (0 = one per hardware thread).
+    static bool generate(const std::string& directory, const std::vector<std::string>& names, int threads,
+                         std::ostream& log);
+
+    // Names of all tables, in an order where each only needs earlier ones
+    static std::vector<std::string> allTables();
+
+private:
+    struct Table;
+
+    bool load(const std::string& filename);
+    bool generateTable(const std::string& name, const std::string& filename, int threads, std::ostream& log);
+
+    // Byte stored for the position, or 0xFE if no table has it
+    uint8_t probeValue(TablebasePosition position) const;
+
+    std::map<uint64_t, std::unique_ptr<Table>> tables; // By material signature
+};
+
+#endif // TABLEBASE_H
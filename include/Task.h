@@ -0,0 +1,95 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+// Coroutine frames are recycled through per-thread free lists. A cooperative
+// search creates and destroys a frame for every interior node, which would
+// otherwise go through the general-purpose allocator each time.
+class FramePool {
+public:
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr, size_t size);
+};
+
+// Lazily started coroutine returning a T. Awaiting a Task runs it and resumes
+// the awaiting coroutine when it finishes, without growing the stack
+// (symmetric transfer), so tasks can nest as deep as the search does.
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        T value{};
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                std::coroutine_handle<> next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T v) { value = std::move(v); }
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        static void* operator new(size_t size) { return FramePool::allocate(size); }
+        static void operator delete(void* ptr, size_t size) { FramePool::deallocate(ptr, size); }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    // co_await support
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return result(); }
+
+    // Driving a top-level task by hand (see SearchScheduler)
+    std::coroutine_handle<> start() const { return handle; }
+    bool done() const { return !handle || handle.done(); }
+    T result() {
+        if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+        return std::move(handle.promise().value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Suspends the whole chain of awaiting tasks back to whoever resumed it,
+// storing the innermost coroutine in 'resumePoint' so it can be continued later.
+struct YieldTo {
+    std::coroutine_handle<>& resumePoint;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { resumePoint = h; }
+    void await_resume() const noexcept {}
+};
+
+#endif // TASK_H
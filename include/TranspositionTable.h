@@ -0,0 +1,58 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum TTBound : uint8_t {
+    TT_NONE = 0,
+    TT_UPPER = 1, // Score is at most the stored value (fail low)
+    TT_LOWER = 2, // Score is at least the stored value (fail high)
+    TT_EXACT = 3
+};
+
+struct TTEntry {
+    int score;
+    int depth;
+    TTBound bound;
+    uint16_t move; // packTraceMove() encoding, 0 if none
+};
+
+// Shared hash table of search results. Safe to use from several searches at
+// once without locking: every slot stores key ^ data next to data, so a slot
+// torn by concurrent writers fails the key check and reads as a miss.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocates (and clears) the table. Not safe while searches are running.
+    void resize(size_t megabytes);
+    void clear();
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int score, int depth, TTBound bound, uint16_t move);
+
+    size_t getSizeMB() const { return sizeMB; }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    // Slot 0 keeps the deepest result, slot 1 always takes the newest
+    struct Bucket {
+        Slot slots[2];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketMask;
+    size_t sizeMB;
+};
+
+#endif // TRANSPOSITION_TABLE_H
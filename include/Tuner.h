@@ -0,0 +1,47 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TunerOptions {
+    int threads = 0;             // 0 = one per hardware thread
+    int epochs = 500;            // Full passes over the data
+    double learningRate = 1.0;   // Adam step size, in centipawns
+    double lambda = 1.0;         // Target weight of the game result; the rest is the search score (not with EPD)
+    double scale = 0;            // Sigmoid scaling constant K, 0 = fit it to the data first
+};
+
+// Texel tuning of the weights in EvalTables.h.
+//
+// The tuned part of the evaluation is linear in its weights: every piece
+// adds its material value and square table entry, positive for White and
+// negative for Black. The attack terms of Board::evaluate (mobility, king
+// safety, threats) are fixed and not tuned.
+// Positions are read straight from memory-mapped PackedPosition files, and
+// the weights minimize the mean squared error between
+// 1 / (1 + 10^(-K * eval / 400)) and the target (game result, optionally
+// blended with the search score) with Adam on full-batch gradients computed
+// on several threads.
+class Tuner {
+public:
+    // Adds the records of a PackedPosition file (.bin) or of an EPD file with
+    // a result per line (c9 "1-0"; or a trailing [1.0]). Returns false if unreadable.
+    bool load(const std::string& filename, std::ostream& log);
+
+    size_t getPositionCount() const;
+
+    // Tunes from the current tables and writes them as C++ source in the
+    // layout of src/EvalTables.cpp. Progress goes to 'log'.
+    bool run(const TunerOptions& options, const std::string& outputFile, std::ostream& log);
+
+private:
+    struct Dataset;
+    std::vector<std::shared_ptr<Dataset>> datasets;
+};
+
+#endif // TUNER_H
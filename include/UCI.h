@@ -2,19 +2,85 @@
 #define UCI_H
 
 #include "Board.h"
+#include "MateSearch.h"
+#include "OpeningExplorer.h"
+#include "PolyglotBook.h"
 #include "Search.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 class UCI {
 public:
-    // Starts the UCI loop. This blocks until "quit" is received.
+    explicit UCI(std::ostream& out = std::cout);
+    ~UCI();
+
+    // Starts the UCI loop on stdin. This blocks until "quit" is received.
+    // "go" searches in the background so "stop" and "isready" are answered
+    // while it runs.
     void loop();
 
+    // Runs a single command line. Returns false for "quit". Outside loop(),
+    // "go" runs to completion before this returns.
+    bool handleCommand(const std::string& line);
+
+    // Interrupts a running "go" from another thread; it still prints bestmove.
+    // A "go ponder" search is interrupted the same way.
+    // The request stays pending until clearStop(), see Search::stop().
+    // Both reach the mate solver as well, for a running "go mate N".
+    void stop() {
+        search.stop();
+        mateSearch.stop();
+    }
+    void clearStop() {
+        search.clearStop();
+        mateSearch.clearStop();
+    }
+
+    // Uses a table owned by someone else (the daemon). A shared table is not
+    // cleared by "ucinewgame" and cannot be resized with "setoption name Hash".
+    void shareTranspositionTable(std::shared_ptr<TranspositionTable> table);
+
+    // Uses an analysis cache opened with --cache; "setoption name
+    // AnalysisFile" is then refused.
+    void shareAnalysisCache(std::shared_ptr<AnalysisCache> cache);
+
 private:
+    std::ostream& out;
     Board board;
     Search search;
+    MateSearch mateSearch;    // "go mate N"
+    bool sharedHash;
+    bool sharedCache;
+    bool background;          // "go" runs on searchThread (set by loop())
+
+    // Opening book (OwnBook, BookFile, BookDepth, BookBestMove): a Polyglot
+    // book or an opening explorer index
+    PolyglotBook book;
+    OpeningExplorer explorerBook;
+    bool ownBook;
+    int bookDepth;            // Last full move number played from the book
+    bool bookBestMove;        // Highest weight instead of weighted random
+    int multiPV;              // Lines reported per iteration
+    bool ponder;              // Suggest a move to ponder on after bestmove
+    std::thread searchThread;
+
+    // The last "position" command, so a command that only appends moves to
+    // the same game replays just the new ones (or unmakes a takeback).
+    std::string positionBase;          // "startpos" or "fen <fen>"
+    std::string appliedMoves;          // Move list text applied on top of positionBase
+    std::vector<Move> appliedMoveList; // The same moves, for unmaking
+
+    bool applyMoves(std::string_view moves);
 
     void handlePosition(const std::string& line);
     void handleGo(const std::string& line);
+    void runSearch(const SearchLimits& limits, int mateMoves);
+    void waitForSearch();
+    void handleSetOption(const std::string& line);
 };
 
 #endif // UCI_H
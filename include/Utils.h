@@ -1,6 +1,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "Board.h"
 #include <string>
 #include <vector>
 
@@ -11,6 +12,9 @@ int parseSquare(const std::string& s);
 // Converts square index (0-63) to algebraic notation (e.g., "e4").
 std::string squareToString(int square);
 
+// Converts a move to UCI long algebraic notation (e.g., "e7e8q"); "0000" for no move.
+std::string moveToUci(const Move& move);
+
 // Helper to split a string by a delimiter
 std::vector<std::string> split(const std::string& s, char delimiter);
 
@@ -0,0 +1,98 @@
+#ifndef OCTANT_C_API_H
+#define OCTANT_C_API_H
+
+/*
+ * C API of the Octant engine (liboctant). Lets other languages embed the
+ * engine in-process instead of driving `Octant --uci` over a pipe.
+ *
+ * An OctantEngine holds one board and one search and must be used from one
+ * thread at a time, except octant_stop(), which may be called from any
+ * thread. Different engines can search concurrently and may share a
+ * transposition table.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define OCTANT_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define OCTANT_API __attribute__((visibility("default")))
+#else
+#define OCTANT_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OCTANT_OK 0
+#define OCTANT_ERROR_ARGUMENT -1   /* Null handle or invalid argument */
+#define OCTANT_ERROR_FEN -2        /* Position could not be parsed */
+#define OCTANT_ERROR_MOVE -3       /* Illegal move in the move list */
+#define OCTANT_ERROR_INTERNAL -4
+
+typedef struct OctantEngine OctantEngine;
+typedef struct OctantTable OctantTable;
+
+typedef struct {
+    int depth;          /* Deepest iteration, 0 = no limit (up to 64) */
+    int64_t movetime;   /* Milliseconds, 0 = no limit */
+    uint64_t nodes;     /* 0 = no limit */
+} OctantLimits;
+
+typedef struct {
+    int depth;
+    int score;          /* Centipawns, side to move's point of view */
+    int mate;           /* Moves to mate if non-zero (negative: getting mated) */
+    uint64_t nodes;
+    uint64_t nps;
+    int64_t time;       /* Milliseconds */
+    const char* pv;     /* Space-separated UCI moves, valid during the callback */
+} OctantInfo;
+
+/* Called after every completed iteration, on the searching thread */
+typedef void (*OctantInfoCallback)(const OctantInfo* info, void* user);
+
+OCTANT_API const char* octant_version(void);
+
+/* Transposition table that several engines can share. An engine keeps the
+ * table alive, so it may be released while engines still use it. */
+OCTANT_API OctantTable* octant_table_create(size_t megabytes);
+OCTANT_API void octant_table_release(OctantTable* table);
+
+/* table may be NULL for a private 16 MB table. Returns NULL on failure. */
+OCTANT_API OctantEngine* octant_create(OctantTable* table);
+OCTANT_API void octant_destroy(OctantEngine* engine);
+
+/* position is "startpos" or a FEN; moves is a space-separated list of UCI
+ * moves (may be NULL). The position is unchanged on error. */
+OCTANT_API int octant_set_position(OctantEngine* engine, const char* position, const char* moves);
+
+/* Writes the current position as FEN; returns the length or an error code */
+OCTANT_API int octant_get_fen(OctantEngine* engine, char* buffer, size_t size);
+
+/* Searches the current position. bestmove receives the UCI move ("0000" if
+ * there is none) and must hold at least 6 bytes; score may be NULL. */
+OCTANT_API int octant_search(OctantEngine* engine, const OctantLimits* limits,
+                             OctantInfoCallback callback, void* user,
+                             char* bestmove, int* score);
+
+/* Makes a running octant_search return as soon as possible. Has no effect
+ * when no search is running. */
+OCTANT_API void octant_stop(OctantEngine* engine);
+
+/* Clears the table (when not shared) and resets to the start position */
+OCTANT_API void octant_new_game(OctantEngine* engine);
+
+/* Leaf count of the legal move tree; 0 on error */
+OCTANT_API uint64_t octant_perft(OctantEngine* engine, int depth);
+
+/* Static evaluation in centipawns, White's point of view */
+OCTANT_API int octant_evaluate(OctantEngine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCTANT_C_API_H */
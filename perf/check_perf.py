@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Performance regression check for Octant.
+
+Runs `Octant --perf-json`, then compares the results with a checked-in
+baseline:
+
+  * "signature" entries (perft counts, bench node totals) must match exactly.
+    A change here means move generation or search behaviour changed.
+  * "throughput" entries (nodes/s, ops/s) may not drop by more than the
+    configured tolerance, e.g. 0.25 = fail below 75% of the baseline.
+
+Tolerances come from the baseline's "tolerance" object ("default" plus
+optional per-metric overrides) and can be overridden with --tolerance or
+the OCTANT_PERF_TOLERANCE environment variable.
+
+Use --update to rewrite the baseline from the current run after an
+intentional change.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def run_engine(engine):
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "perf.json")
+        subprocess.run([engine, "--perf-json", out], check=True,
+                       stdout=subprocess.DEVNULL)
+        with open(out) as f:
+            return json.load(f)
+
+
+def compare(baseline, current, override):
+    tolerances = baseline.get("tolerance", {})
+    default_tol = override if override is not None else tolerances.get("default", 0.25)
+    rows = []
+    failed = False
+
+    for name, expected in sorted(baseline.get("signature", {}).items()):
+        actual = current["signature"].get(name)
+        ok = actual == expected
+        failed |= not ok
+        rows.append((name, str(expected), str(actual), "", "ok" if ok else "SIGNATURE CHANGED"))
+
+    for name, expected in sorted(baseline.get("throughput", {}).items()):
+        actual = current["throughput"].get(name)
+        tol = default_tol if override is not None else tolerances.get(name, default_tol)
+        if actual is None:
+            failed = True
+            rows.append((name, str(expected), "missing", "", "MISSING"))
+            continue
+        ratio = actual / expected if expected else 1.0
+        ok = ratio >= 1.0 - tol
+        failed |= not ok
+        status = "ok" if ok else "REGRESSION (limit -%d%%)" % round(tol * 100)
+        rows.append((name, str(expected), str(actual), "%+.1f%%" % ((ratio - 1.0) * 100), status))
+
+    widths = [max(len(r[i]) for r in rows + [("metric", "baseline", "current", "delta", "")])
+              for i in range(4)]
+    header = ("metric", "baseline", "current", "delta", "status")
+    for row in [header] + rows:
+        print("  ".join(col.ljust(widths[i]) if i < 4 else col for i, col in enumerate(row)))
+    return not failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--engine", required=True, help="path to the Octant executable")
+    parser.add_argument("--baseline", required=True, help="baseline JSON file")
+    parser.add_argument("--tolerance", type=float, default=None,
+                        help="allowed throughput drop for every metric (0.25 = 25%%)")
+    parser.add_argument("--update", action="store_true",
+                        help="write the current results to the baseline and exit")
+    args = parser.parse_args()
+
+    override = args.tolerance
+    if override is None and os.environ.get("OCTANT_PERF_TOLERANCE"):
+        override = float(os.environ["OCTANT_PERF_TOLERANCE"])
+
+    current = run_engine(args.engine)
+
+    if args.update:
+        baseline = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                baseline = json.load(f)
+        baseline["signature"] = current["signature"]
+        baseline["throughput"] = current["throughput"]
+        baseline.setdefault("tolerance", {"default": 0.25})
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Updated", args.baseline)
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+    return 0 if compare(baseline, current, override) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Endgame tablebase checks for Octant.
+
+Generates the tables into a temporary directory with `Octant --tb-generate`
+and checks them against known values:
+
+  * the longest mates of KQK, KRK, KPK, KBNK and KQKR;
+  * positions whose value depends on an en passant reply to a double push.
+"""
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+LONGEST_MATES = {"KQK": 20, "KRK": 32, "KPK": 56, "KBNK": 66, "KQKR": 70}
+
+# FEN, expected first line of --tb-probe after the FEN
+PROBES = [
+    # 1.e4 dxe3 e.p., 1.e3 dxe3 and 1.Kxd4 Kxe2 all leave K vs K
+    ("8/8/8/8/3p4/3K4/4P3/3k4 w - - 0 1", "draw"),
+]
+
+
+def check(name, ok, detail):
+    print("%-32s %s (%s)" % (name, "ok" if ok else "FAILED", detail))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--engine", required=True, help="path to the Octant executable")
+    args = parser.parse_args()
+
+    passed = True
+    with tempfile.TemporaryDirectory() as directory:
+        tables = sorted(LONGEST_MATES) + ["KPKP"]
+        output = subprocess.run([args.engine, "--tb-generate", directory, *tables,
+                                 "--workers", str(os.cpu_count() or 1)],
+                                check=True, capture_output=True, text=True).stdout
+        longest = {m.group(1): int(m.group(2))
+                   for m in re.finditer(r"^(\w+): .* longest mate (\d+) plies", output, re.M)}
+        for name, expected in sorted(LONGEST_MATES.items()):
+            actual = longest.get(name)
+            passed &= check("longest mate " + name, actual == expected,
+                            "%s plies, expected %d" % (actual, expected))
+
+        for fen, expected in PROBES:
+            output = subprocess.run([args.engine, "--tb-probe", directory, "--fen", fen],
+                                    check=True, capture_output=True, text=True).stdout
+            value = output.splitlines()[0].split(": ", 1)[-1] if output else "no output"
+            passed &= check("probe " + fen.split()[0], value == expected,
+                            "%s, expected %s" % (value, expected))
+    return 0 if passed else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""UCI protocol timing checks for Octant.
+
+Drives `Octant --uci` through a pipe and checks that searches answer when
+they should:
+
+  * "go ponder" followed at once by "ponderhit" plays on its clock instead
+    of pondering until "stop" (the ponderhit must not be lost while the
+    search thread is starting).
+  * "stop" during a ponder search answers with a bestmove.
+"""
+import argparse
+import queue
+import subprocess
+import sys
+import threading
+import time
+
+
+class Engine:
+    def __init__(self, path):
+        self.process = subprocess.Popen([path, "--uci"], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        text=True, bufsize=1)
+        self.lines = queue.Queue()
+        threading.Thread(target=self._read, daemon=True).start()
+
+    def _read(self):
+        for line in self.process.stdout:
+            self.lines.put(line.strip())
+
+    def send(self, *commands):
+        for command in commands:
+            self.process.stdin.write(command + "\n")
+        self.process.stdin.flush()
+
+    def wait_for(self, prefix, timeout):
+        """Returns the first line starting with 'prefix', or None after 'timeout' seconds."""
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return None
+            try:
+                line = self.lines.get(timeout=remaining)
+            except queue.Empty:
+                return None
+            if line.startswith(prefix):
+                return line
+
+    def close(self):
+        try:
+            self.send("stop", "quit")
+            self.process.wait(timeout=10)
+        except (OSError, subprocess.TimeoutExpired):
+            self.process.kill()
+
+
+def check(name, ok, detail):
+    print("%-32s %s (%s)" % (name, "ok" if ok else "FAILED", detail))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--engine", required=True, help="path to the Octant executable")
+    args = parser.parse_args()
+
+    engine = Engine(args.engine)
+    passed = True
+    try:
+        engine.send("uci", "setoption name Ponder value true", "isready")
+        passed &= check("startup", engine.wait_for("readyok", 10) is not None, "readyok")
+
+        # About 33 ms of thinking once ponderhit arrives; a lost ponderhit
+        # ponders on until the timeout
+        engine.send("position startpos moves e2e4", "go ponder wtime 1000 btime 1000", "ponderhit")
+        start = time.monotonic()
+        line = engine.wait_for("bestmove", 3)
+        passed &= check("immediate ponderhit", line is not None,
+                        "%.2fs" % (time.monotonic() - start) if line else "no bestmove after 3s")
+
+        engine.send("position startpos moves e2e4", "go ponder wtime 1000 btime 1000")
+        time.sleep(0.2)
+        engine.send("stop")
+        line = engine.wait_for("bestmove", 3)
+        passed &= check("stop while pondering", line is not None, line or "no bestmove after 3s")
+
+        # The stopped ponder search must not leave the next search pondering
+        engine.send("go wtime 1000 btime 1000")
+        line = engine.wait_for("bestmove", 3)
+        passed &= check("search after ponder stop", line is not None, line or "no bestmove after 3s")
+    finally:
+        engine.close()
+    return 0 if passed else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,150 @@
+"""ctypes binding for liboctant (include/octant.h).
+
+Runs the engine inside the Python process: no child process, pipe or UCI
+text parsing per request. ctypes releases the GIL while a search runs, so
+several engines can search at once from different threads.
+
+    python3 octant_ctypes.py [path/to/liboctant.so]
+"""
+import ctypes
+import os
+import sys
+
+OCTANT_OK = 0
+ERRORS = {-1: 'invalid argument', -2: 'invalid FEN', -3: 'illegal move', -4: 'internal error'}
+
+
+class OctantLimits(ctypes.Structure):
+    _fields_ = [('depth', ctypes.c_int),
+                ('movetime', ctypes.c_int64),
+                ('nodes', ctypes.c_uint64)]
+
+
+class OctantInfo(ctypes.Structure):
+    _fields_ = [('depth', ctypes.c_int),
+                ('score', ctypes.c_int),
+                ('mate', ctypes.c_int),
+                ('nodes', ctypes.c_uint64),
+                ('nps', ctypes.c_uint64),
+                ('time', ctypes.c_int64),
+                ('pv', ctypes.c_char_p)]
+
+
+INFO_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.POINTER(OctantInfo), ctypes.c_void_p)
+
+
+def default_library_path():
+    here = os.path.dirname(os.path.abspath(__file__))
+    name = {'darwin': 'liboctant.dylib', 'win32': 'octant.dll'}.get(sys.platform, 'liboctant.so')
+    return os.environ.get('OCTANT_LIBRARY', os.path.join(here, '..', 'build', name))
+
+
+class Library:
+    def __init__(self, path=None):
+        lib = ctypes.CDLL(path or default_library_path())
+        lib.octant_version.restype = ctypes.c_char_p
+        lib.octant_table_create.argtypes = [ctypes.c_size_t]
+        lib.octant_table_create.restype = ctypes.c_void_p
+        lib.octant_table_release.argtypes = [ctypes.c_void_p]
+        lib.octant_create.argtypes = [ctypes.c_void_p]
+        lib.octant_create.restype = ctypes.c_void_p
+        lib.octant_destroy.argtypes = [ctypes.c_void_p]
+        lib.octant_set_position.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+        lib.octant_get_fen.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+        lib.octant_search.argtypes = [ctypes.c_void_p, ctypes.POINTER(OctantLimits), INFO_CALLBACK,
+                                      ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(ctypes.c_int)]
+        lib.octant_stop.argtypes = [ctypes.c_void_p]
+        lib.octant_new_game.argtypes = [ctypes.c_void_p]
+        lib.octant_perft.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        lib.octant_perft.restype = ctypes.c_uint64
+        lib.octant_evaluate.argtypes = [ctypes.c_void_p]
+        self.lib = lib
+
+    def version(self):
+        return self.lib.octant_version().decode()
+
+
+class Table:
+    """Transposition table shared by several engines."""
+
+    def __init__(self, library, megabytes=64):
+        self.library = library
+        self.handle = library.lib.octant_table_create(megabytes)
+        if not self.handle:
+            raise MemoryError('cannot allocate transposition table')
+
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            self.library.lib.octant_table_release(self.handle)
+            self.handle = None
+
+
+class Engine:
+    """One board and search. Use from one thread at a time; stop() may be
+    called from any thread."""
+
+    def __init__(self, library, table=None):
+        self.library = library
+        self.lib = library.lib
+        self.handle = self.lib.octant_create(table.handle if table else None)
+        if not self.handle:
+            raise MemoryError('cannot create engine')
+
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            self.lib.octant_destroy(self.handle)
+            self.handle = None
+
+    def set_position(self, position='startpos', moves=()):
+        status = self.lib.octant_set_position(self.handle, position.encode(), ' '.join(moves).encode())
+        if status != OCTANT_OK:
+            raise ValueError(ERRORS.get(status, status))
+
+    def fen(self):
+        buffer = ctypes.create_string_buffer(128)
+        status = self.lib.octant_get_fen(self.handle, buffer, len(buffer))
+        if status < 0:
+            raise ValueError(ERRORS.get(status, status))
+        return buffer.value.decode()
+
+    def search(self, depth=0, movetime=0, nodes=0, on_info=None):
+        """Returns (bestmove, score). on_info(dict) is called per iteration."""
+        def forward(info, _user):
+            if on_info:
+                i = info.contents
+                score = {'mate': i.mate} if i.mate else {'cp': i.score}
+                on_info({'depth': i.depth, 'score': score, 'nodes': i.nodes, 'nps': i.nps,
+                         'time': i.time, 'pv': i.pv.decode().split()})
+
+        callback = INFO_CALLBACK(forward)  # Must stay referenced during the call
+        limits = OctantLimits(depth, movetime, nodes)
+        bestmove = ctypes.create_string_buffer(8)
+        score = ctypes.c_int()
+        status = self.lib.octant_search(self.handle, ctypes.byref(limits), callback, None,
+                                        bestmove, ctypes.byref(score))
+        if status != OCTANT_OK:
+            raise RuntimeError(ERRORS.get(status, status))
+        return bestmove.value.decode(), score.value
+
+    def stop(self):
+        self.lib.octant_stop(self.handle)
+
+    def new_game(self):
+        self.lib.octant_new_game(self.handle)
+
+    def perft(self, depth):
+        return self.lib.octant_perft(self.handle, depth)
+
+    def evaluate(self):
+        return self.lib.octant_evaluate(self.handle)
+
+
+if __name__ == '__main__':
+    library = Library(sys.argv[1] if len(sys.argv) > 1 else None)
+    engine = Engine(library)
+    print(library.version())
+    print('perft 4:', engine.perft(4))
+    engine.set_position('startpos', ['e2e4', 'e7e5'])
+    print('fen:', engine.fen())
+    print('eval:', engine.evaluate())
+    print('search:', engine.search(depth=5, on_info=print))
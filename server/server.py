@@ -1,71 +1,361 @@
+import collections
+import json
+import os
+import queue
+import re
+import socket
 import subprocess
 import threading
 import time
-from flask import Flask, request, jsonify, send_from_directory
+import uuid
+from flask import Flask, Response, request, jsonify, send_from_directory, stream_with_context
 
 app = Flask(__name__, static_folder='../web', static_url_path='')
 
-class Engine:
+ENGINE_PATH = os.environ.get('OCTANT_ENGINE', '../build/Octant')
+SOCKET_PATH = os.environ.get('OCTANT_SOCKET', '/tmp/octant.sock')
+BACKEND = os.environ.get('OCTANT_BACKEND', 'daemon')  # "daemon" or "inprocess" (liboctant via ctypes)
+SEARCH_TIMEOUT = 30.0
+KEEPALIVE = 1.0  # Seconds between SSE comments; a failed write is how a closed tab is noticed
+MAX_SESSIONS = 256  # In-process engines kept before the least recently used is dropped
+
+# Both backends report a search as a sequence of events:
+#   ('info', {...})      one per completed iteration, see parse_info
+#   ('bestmove', 'e2e4')
+#   ('busy', None)       the engine refused the search
+#   None                 nothing happened for KEEPALIVE seconds
+
+
+def parse_info(line):
+    """Turns a UCI "info depth ... score ... pv ..." line into a dict."""
+    tokens = line.split()
+    info = {}
+    i = 1
+    while i < len(tokens):
+        key = tokens[i]
+        if key in ('depth', 'nodes', 'nps', 'time') and i + 1 < len(tokens):
+            info[key] = int(tokens[i + 1])
+            i += 2
+        elif key == 'score' and i + 2 < len(tokens):
+            info['score'] = {tokens[i + 1]: int(tokens[i + 2])}  # {"cp": 35} or {"mate": 3}
+            i += 3
+        elif key == 'pv':
+            info['pv'] = tokens[i + 1:]
+            break
+        else:
+            i += 1
+    return info
+
+
+def parse_go(go):
+    """Search limits of "go [movetime N | depth N | infinite]" for liboctant."""
+    tokens = go.split()
+    for key in ('movetime', 'depth'):
+        if key in tokens:
+            return {key: int(tokens[tokens.index(key) + 1])}
+    if 'infinite' in tokens:
+        return {}
+    return {'depth': 4}
+
+
+def next_item(items, deadline):
+    """Next queued item, or None after KEEPALIVE seconds. Raises queue.Empty
+    once the deadline has passed."""
+    wait = KEEPALIVE
+    if deadline is not None:
+        if time.time() >= deadline:
+            raise queue.Empty
+        wait = min(wait, deadline - time.time())
+    try:
+        return items.get(timeout=max(0.0, wait))
+    except queue.Empty:
+        return None
+
+
+class Backend:
+    def __init__(self):
+        self.locks_lock = threading.Lock()
+        self.locks = {}
+
+    def session_lock(self, session):
+        """Held for a whole search so two requests of one game don't mix output."""
+        with self.locks_lock:
+            return self.locks.setdefault(session, threading.Lock())
+
+    def search(self, session, moves):
+        """Returns (bestmove, events); bestmove is None if the engine is busy."""
+        events = [event for event in self.stream(session, moves, timeout=SEARCH_TIMEOUT) if event is not None]
+        kind, value = events[-1]
+        return (value if kind == 'bestmove' else None), events
+
+
+class DaemonEngine(Backend):
+    """Client for `Octant --daemon`.
+
+    Every browser game is a daemon session: commands are sent as
+    "<session> <uci command>" and a reader thread routes the prefixed output
+    lines to a queue per session, so games search in parallel instead of
+    waiting for each other.
+    """
+
     def __init__(self):
-        self.process = subprocess.Popen(
-            ['../build/Octant', '--uci'],
-            stdin=subprocess.PIPE,
-            stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            text=True,
-            bufsize=1
-        )
-        self.lock = threading.Lock()
-
-    def send_command(self, cmd):
-        with self.lock:
-            self.process.stdin.write(cmd + '\n')
-            self.process.stdin.flush()
-
-    def read_output(self, timeout=1.0):
-        # Simple non-blocking read with timeout
-        # In a real engine, we'd have a dedicated reader thread
-        start = time.time()
-        lines = []
-        while time.time() - start < timeout:
-            line = self.process.stdout.readline()
-            if line:
-                lines.append(line.strip())
-                if line.startswith('bestmove'):
+        super().__init__()
+        self.sock = self.connect()
+        self.send_lock = threading.Lock()
+        self.queues_lock = threading.Lock()
+        self.queues = {}
+        threading.Thread(target=self.read_loop, daemon=True).start()
+
+    def connect(self):
+        try:
+            return self.open_socket()
+        except OSError:
+            pass
+        # No daemon yet: start one and wait for its socket
+        subprocess.Popen([ENGINE_PATH, '--daemon', '--socket', SOCKET_PATH])
+        deadline = time.time() + 5.0
+        while True:
+            try:
+                return self.open_socket()
+            except OSError:
+                if time.time() > deadline:
+                    raise
+                time.sleep(0.05)
+
+    def open_socket(self):
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(SOCKET_PATH)
+        except OSError:
+            sock.close()
+            raise
+        return sock
+
+    def session_queue(self, session):
+        with self.queues_lock:
+            return self.queues.setdefault(session, queue.Queue())
+
+    def send_command(self, session, cmd):
+        with self.send_lock:
+            self.sock.sendall(f'{session} {cmd}\n'.encode())
+
+    def read_loop(self):
+        for raw in self.sock.makefile('r', encoding='utf-8'):
+            session, _, line = raw.rstrip('\n').partition(' ')
+            self.session_queue(session).put(line)
+
+    def stream(self, session, moves, go='go', timeout=None):
+        """Yields the events of one search, ending with bestmove or busy.
+
+        Raises queue.Empty after `timeout` seconds. If the caller stops early
+        (client gone, timeout) the search is stopped and its output drained.
+        """
+        lines = self.session_queue(session)
+        deadline = time.time() + timeout if timeout else None
+        with self.session_lock(session):
+            self.send_command(session, 'position startpos moves ' + ' '.join(moves))
+            self.send_command(session, go)
+            finished = False
+            try:
+                while True:
+                    line = next_item(lines, deadline)
+                    if line is None:
+                        yield None
+                    elif line.startswith('info depth'):
+                        yield 'info', parse_info(line)
+                    elif line.startswith('error busy'):
+                        self.sync(session, lines, time.time() + SEARCH_TIMEOUT)
+                        finished = True
+                        yield 'busy', None
+                        return
+                    elif line.startswith('bestmove'):
+                        finished = True
+                        yield 'bestmove', line.split()[1]
+                        return
+            finally:
+                if not finished:
+                    self.stop(session)
+                    self.sync(session, lines, time.time() + SEARCH_TIMEOUT)
+
+    def stop(self, session):
+        self.send_command(session, 'stop')
+
+    def sync(self, session, lines, deadline):
+        """Waits until the session has no queued commands and drops their output.
+
+        If only the position command was rejected the search still runs, and
+        its bestmove must not be taken as the answer to the next request.
+        """
+        while True:
+            self.send_command(session, 'isready')
+            while True:
+                line = lines.get(timeout=max(0.0, deadline - time.time()))
+                if line == 'readyok':
+                    return
+                if line.startswith('error busy'):
+                    time.sleep(0.1)
                     break
-            else:
-                time.sleep(0.01)
-        return lines
 
-engine = Engine()
-engine.send_command('uci')
+
+class InProcessEngine(Backend):
+    """Runs liboctant inside this process through ctypes (octant_ctypes.py).
+
+    Every browser game gets its own engine, all sharing one transposition
+    table; there is no child process, socket or UCI text on the way.
+    """
+
+    def __init__(self):
+        super().__init__()
+        import octant_ctypes
+        self.octant = octant_ctypes
+        self.library = octant_ctypes.Library()
+        self.table = octant_ctypes.Table(self.library, 64)
+        self.engines_lock = threading.Lock()
+        self.engines = collections.OrderedDict()
+
+    def engine(self, session):
+        with self.engines_lock:
+            engine = self.engines.pop(session, None) or self.octant.Engine(self.library, self.table)
+            self.engines[session] = engine
+            while len(self.engines) > MAX_SESSIONS:
+                self.engines.popitem(last=False)
+            return engine
+
+    def stream(self, session, moves, go='go', timeout=None):
+        """Same events as DaemonEngine.stream; the search runs on its own thread."""
+        deadline = time.time() + timeout if timeout else None
+        events = queue.Queue()
+        with self.session_lock(session):
+            engine = self.engine(session)
+            try:
+                engine.set_position('startpos', moves)
+            except ValueError:
+                yield 'bestmove', '0000'
+                return
+
+            def run():
+                try:
+                    best, _ = engine.search(on_info=lambda info: events.put(('info', info)), **parse_go(go))
+                except RuntimeError:
+                    best = '0000'
+                events.put(('bestmove', best))
+
+            thread = threading.Thread(target=run, daemon=True)
+            thread.start()
+            finished = False
+            try:
+                while True:
+                    event = next_item(events, deadline)
+                    yield event
+                    if event is not None and event[0] == 'bestmove':
+                        finished = True
+                        return
+            finally:
+                if not finished:
+                    engine.stop()
+                thread.join()
+
+    def stop(self, session):
+        with self.engines_lock:
+            engine = self.engines.get(session)
+        if engine:
+            engine.stop()
+
+
+engine = InProcessEngine() if BACKEND == 'inprocess' else DaemonEngine()
+
+
+def valid_session(session):
+    return session.isalnum() and len(session) <= 64
+
+
+UCI_MOVE = re.compile(r'[a-h][1-8][a-h][1-8][qrbn]?')
+
+
+def valid_moves(moves):
+    """Moves are joined into a UCI command, so anything else could inject one."""
+    return isinstance(moves, list) and all(isinstance(m, str) and UCI_MOVE.fullmatch(m) for m in moves)
+
 
 @app.route('/')
 def index():
     return send_from_directory('../web', 'index.html')
 
+
 @app.route('/move', methods=['POST'])
 def move():
-    data = request.json
-    fen = data.get('fen') # Not used yet by engine, but good for stateless
-    moves = data.get('moves') # List of moves from startpos
-    
-    # Construct UCI command
-    cmd = "position startpos moves " + " ".join(moves)
-    engine.send_command(cmd)
-    
-    # Ask engine to search
-    engine.send_command("go")
-    
-    # Wait for bestmove
-    output = engine.read_output(timeout=5.0)
-    best_move = None
-    for line in output:
-        if line.startswith('bestmove'):
-            best_move = line.split()[1]
-            break
-            
-    return jsonify({'bestmove': best_move, 'logs': output})
+    data = request.get_json(silent=True)
+    if not isinstance(data, dict):
+        return jsonify({'error': 'invalid request'}), 400
+    session = data.get('session') or uuid.uuid4().hex
+    moves = data.get('moves') or []  # List of moves from startpos
+
+    if not isinstance(session, str) or not valid_session(session):
+        return jsonify({'error': 'invalid session'}), 400
+    if not valid_moves(moves):
+        return jsonify({'error': 'invalid moves'}), 400
+
+    try:
+        best_move, events = engine.search(session, moves)
+    except queue.Empty:
+        return jsonify({'error': 'engine timeout'}), 504
+    if best_move is None:
+        return jsonify({'error': 'engine busy'}), 503
+
+    return jsonify({'bestmove': best_move, 'info': [value for kind, value in events if kind == 'info']})
+
+
+def sse(event, data):
+    return f'event: {event}\ndata: {json.dumps(data)}\n\n'
+
+
+@app.route('/analyse')
+def analyse():
+    """Streams a search as Server-Sent Events: one "info" event per completed
+    iteration, then "bestmove" (or "busy"). Closing the stream or POSTing
+    /stop ends the search."""
+    session = request.args.get('session') or uuid.uuid4().hex
+    moves = request.args.get('moves', '').split()
+    if not valid_session(session):
+        return jsonify({'error': 'invalid session'}), 400
+    if not valid_moves(moves):
+        return jsonify({'error': 'invalid moves'}), 400
+
+    go = 'go'
+    try:
+        if request.args.get('movetime'):
+            go = f"go movetime {int(request.args['movetime'])}"
+        elif request.args.get('depth'):
+            go = f"go depth {int(request.args['depth'])}"
+        elif request.args.get('infinite'):
+            go = 'go infinite'
+    except ValueError:
+        return jsonify({'error': 'invalid limit'}), 400
+
+    def events():
+        for event in engine.stream(session, moves, go):
+            if event is None:
+                yield ': keepalive\n\n'
+            elif event[0] == 'info':
+                yield sse('info', event[1])
+            elif event[0] == 'bestmove':
+                yield sse('bestmove', {'bestmove': event[1]})
+            elif event[0] == 'busy':
+                yield sse('busy', {'error': 'engine busy'})
+
+    return Response(stream_with_context(events()), mimetype='text/event-stream',
+                    headers={'Cache-Control': 'no-cache', 'X-Accel-Buffering': 'no'})
+
+
+@app.route('/stop', methods=['POST'])
+def stop():
+    """Ends the session's running search; its stream still gets a bestmove."""
+    session = (request.json or {}).get('session', '')
+    if not valid_session(session):
+        return jsonify({'error': 'invalid session'}), 400
+    engine.stop(session)
+    return jsonify({'ok': True})
+
 
 if __name__ == '__main__':
-    app.run(port=5000)
+    app.run(port=5000, threaded=True)
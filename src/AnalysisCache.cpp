@@ -0,0 +1,148 @@
+#include "AnalysisCache.h"
+#include "Board.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+struct AnalysisCache::Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t generation; // Bumped by every open()
+    uint64_t bucketCount;
+    uint32_t evalVersion; // Board::EVAL_VERSION of the scores
+    uint32_t unused;
+    uint64_t reserved[4];
+};
+
+namespace {
+
+constexpr uint64_t CACHE_MAGIC = 0x31484341544e434fULL; // "OCNTACH1"
+constexpr uint64_t CACHE_INITIALIZING = 1;              // Header being written by another process
+constexpr uint32_t CACHE_VERSION = 2;
+constexpr uint32_t GENERATION_MASK = 0x3f;
+
+// Data layout: score (32 bits) | depth (8) | bound (2) | move (16) | generation (6)
+inline uint64_t packEntry(int score, int depth, TTBound bound, uint16_t move, uint32_t generation) {
+    return (uint64_t)(uint32_t)score
+         | ((uint64_t)(uint8_t)depth << 32)
+         | ((uint64_t)bound << 40)
+         | ((uint64_t)move << 42)
+         | ((uint64_t)(generation & GENERATION_MASK) << 58);
+}
+
+inline TTEntry unpackEntry(uint64_t data) {
+    TTEntry entry;
+    entry.score = (int32_t)(uint32_t)data;
+    entry.depth = (int)(uint8_t)(data >> 32);
+    entry.bound = (TTBound)((data >> 40) & 0x3);
+    entry.move = (uint16_t)(data >> 42);
+    return entry;
+}
+
+inline uint32_t entryGeneration(uint64_t data) {
+    return (uint32_t)(data >> 58);
+}
+
+// The mapping is shared with other processes, so every access is atomic
+inline uint64_t load(const uint64_t& word) {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(word)).load(std::memory_order_relaxed);
+}
+
+inline void save(uint64_t& word, uint64_t value) {
+    std::atomic_ref<uint64_t>(word).store(value, std::memory_order_relaxed);
+}
+
+} // namespace
+
+bool AnalysisCache::open(const std::string& path, size_t megabytes) {
+    static_assert(std::atomic_ref<uint64_t>::is_always_lock_free, "cache entries need lock-free 64-bit atomics");
+    close();
+
+    if (megabytes == 0) megabytes = 1;
+    if (!file.openShared(path, megabytes << 20)) return false;
+    if (file.size() < sizeof(Header) + sizeof(Bucket)) {
+        file.close();
+        return false;
+    }
+
+    // The first process to map a fresh (zeroed) file writes the header
+    Header* header = reinterpret_cast<Header*>(file.writableData());
+    std::atomic_ref<uint64_t> magic(header->magic);
+    uint64_t expected = 0;
+    if (magic.compare_exchange_strong(expected, CACHE_INITIALIZING)) {
+        size_t count = 1;
+        while (sizeof(Header) + count * 2 * sizeof(Bucket) <= file.size()) count *= 2;
+        header->version = CACHE_VERSION;
+        header->evalVersion = Board::EVAL_VERSION;
+        header->bucketCount = count;
+        magic.store(CACHE_MAGIC, std::memory_order_release);
+    } else {
+        for (int i = 0; i < 1000 && magic.load(std::memory_order_acquire) == CACHE_INITIALIZING; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint64_t count = header->bucketCount;
+    if (magic.load(std::memory_order_acquire) != CACHE_MAGIC || header->version != CACHE_VERSION ||
+        header->evalVersion != Board::EVAL_VERSION ||
+        count == 0 || (count & (count - 1)) != 0 || sizeof(Header) + count * sizeof(Bucket) > file.size()) {
+        file.close();
+        return false;
+    }
+
+    generation = (std::atomic_ref<uint32_t>(header->generation).fetch_add(1) + 1) & GENERATION_MASK;
+    buckets = reinterpret_cast<Bucket*>(file.writableData() + sizeof(Header));
+    bucketMask = (size_t)count - 1;
+    filename = path;
+    return true;
+}
+
+void AnalysisCache::close() {
+    file.flush();
+    file.close();
+    buckets = nullptr;
+    bucketMask = 0;
+    filename.clear();
+}
+
+bool AnalysisCache::probe(uint64_t key, TTEntry& entry) const {
+    const Bucket& bucket = buckets[key & bucketMask];
+    for (const Slot& slot : bucket.slots) {
+        uint64_t data = load(slot.data);
+        uint64_t check = load(slot.check);
+        if ((check ^ data) == key && data != 0) {
+            entry = unpackEntry(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AnalysisCache::store(uint64_t key, int score, int depth, TTBound bound, uint16_t move) {
+    Bucket& bucket = buckets[key & bucketMask];
+    Slot* victim = nullptr;
+    int victimWorth = 0;
+    uint64_t data = packEntry(score, depth, bound, move, generation);
+
+    for (Slot& slot : bucket.slots) {
+        uint64_t slotData = load(slot.data);
+        uint64_t slotKey = load(slot.check) ^ slotData;
+        if (slotData != 0 && slotKey == key) {
+            // A deeper result stays, but counts as used in this generation
+            TTEntry old = unpackEntry(slotData);
+            if (old.depth > depth) data = packEntry(old.score, old.depth, old.bound, old.move, generation);
+            victim = &slot;
+            break;
+        }
+        // Empty slots first, then the shallowest after aging
+        int age = (int)((generation - entryGeneration(slotData)) & GENERATION_MASK);
+        int worth = slotData == 0 ? -1000 : unpackEntry(slotData).depth - 2 * age;
+        if (!victim || worth < victimWorth) {
+            victim = &slot;
+            victimWorth = worth;
+        }
+    }
+
+    save(victim->check, key ^ data);
+    save(victim->data, data);
+}
@@ -0,0 +1,124 @@
+#include "BatchEval.h"
+#include "EvalTables.h"
+#include <algorithm>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define OCTANT_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr int LANES = 8;
+constexpr int MAX_PIECES = 32;
+
+// Weight of a packed piece (nibble: type, plus 8 for Black) on a square:
+// material plus table entry, negated for Black. Row 0 is all zero and pads
+// the slots of positions with fewer pieces.
+struct PieceSquareWeights {
+    alignas(64) int32_t value[16 * 64];
+
+    PieceSquareWeights() {
+        std::fill(std::begin(value), std::end(value), 0);
+        for (int type = PAWN; type <= KING; ++type) {
+            for (int square = 0; square < 64; ++square) {
+                value[type * 64 + square] = pieceValues[type] + pieceSquareTables[type][square];
+                value[(type | 8) * 64 + square] = -(pieceValues[type] + pieceSquareTables[type][square ^ 56]);
+            }
+        }
+    }
+};
+
+const PieceSquareWeights& weights() {
+    static const PieceSquareWeights table;
+    return table;
+}
+
+// Eight positions, structure-of-arrays: index[k][lane] is the weight index
+// of the k-th piece of position 'lane'
+struct Block {
+    alignas(32) int32_t index[MAX_PIECES][LANES];
+    int slots = 0;
+};
+
+void fillBlock(const PackedPosition* positions, int count, Block& block) {
+    int slots = 0;
+    for (int lane = 0; lane < count; ++lane) slots = std::max(slots, __builtin_popcountll(positions[lane].occupancy));
+    block.slots = std::min(slots, MAX_PIECES);
+
+    for (int lane = 0; lane < LANES; ++lane) {
+        int k = 0;
+        if (lane < count) {
+            const PackedPosition& p = positions[lane];
+            uint64_t bits = p.occupancy;
+            for (; bits != 0 && k < block.slots; ++k) {
+                int square = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                int nibble = (p.pieces[k / 2] >> (4 * (k % 2))) & 0xF;
+                block.index[k][lane] = nibble * 64 + square;
+            }
+        }
+        for (; k < block.slots; ++k) block.index[k][lane] = 0;
+    }
+}
+
+void sumScalar(const Block& block, const int32_t* table, int* scores, int count) {
+    for (int lane = 0; lane < count; ++lane) {
+        int sum = 0;
+        for (int k = 0; k < block.slots; ++k) sum += table[block.index[k][lane]];
+        scores[lane] = sum;
+    }
+}
+
+#ifdef OCTANT_HAVE_AVX2_KERNEL
+__attribute__((target("avx2"))) void sumAVX2(const Block& block, const int32_t* table, int* scores, int count) {
+    __m256i sum = _mm256_setzero_si256();
+    for (int k = 0; k < block.slots; ++k) {
+        __m256i index = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.index[k]));
+        sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(table, index, 4));
+    }
+    alignas(32) int32_t lanes[LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    std::copy(lanes, lanes + count, scores);
+}
+
+bool haveAVX2() {
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+}
+#endif
+
+template <typename Kernel>
+void evaluateBlocks(const PackedPosition* positions, size_t count, int* scores, Kernel kernel) {
+    const int32_t* table = weights().value;
+    Block block;
+    for (size_t base = 0; base < count; base += LANES) {
+        int n = (int)std::min<size_t>(LANES, count - base);
+        fillBlock(positions + base, n, block);
+        kernel(block, table, scores + base, n);
+    }
+}
+
+} // namespace
+
+void BatchEval::evaluate(const PackedPosition* positions, size_t count, int* scores) {
+#ifdef OCTANT_HAVE_AVX2_KERNEL
+    if (haveAVX2()) {
+        evaluateBlocks(positions, count, scores, sumAVX2);
+        return;
+    }
+#endif
+    evaluateBlocks(positions, count, scores, sumScalar);
+}
+
+void BatchEval::evaluateScalar(const PackedPosition* positions, size_t count, int* scores) {
+    evaluateBlocks(positions, count, scores, sumScalar);
+}
+
+const char* BatchEval::kernelName() {
+#ifdef OCTANT_HAVE_AVX2_KERNEL
+    if (haveAVX2()) return "avx2";
+#endif
+    return "scalar";
+}
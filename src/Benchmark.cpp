@@ -0,0 +1,418 @@
+#include "Benchmark.h"
+#include "BatchEval.h"
+#include "MappedFile.h"
+#include "PGNLoader.h"
+#include "PGNReader.h"
+#include "Search.h"
+#include "SearchScheduler.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Bench positions: openings, middlegames and two endgames.
+const char* const benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqk2r/1pppbppp/p1n2n2/4p3/B3P3/5N2/PPPP1PPP/RNBQ1RK1 w kq - 4 6",
+    "rnbqkb1r/1p2pppp/p2p1n2/8/3NP3/2N5/PPP2PPP/R1BQKB1R w KQkq - 0 6",
+    "rnbq1rk1/ppp1bppp/4pn2/3p2B1/2PP4/2N1P3/PP3PPP/R2QKBNR w KQ - 1 6",
+    "r1b1kbnr/pp3ppp/1qn1p3/2ppP3/3P4/2P2N2/PP3PPP/RNBQKB1R w KQkq - 3 6",
+    "rnbq1rk1/ppp2pbp/3p1np1/4p3/2PPP3/2N2N2/PP2BPPP/R1BQK2R w KQ e6 0 7",
+    "r1b1kb1r/p1ppqppp/2p5/3nP3/8/8/PPP1QPPP/RNB1KB1R w KQkq - 3 8",
+    "rn2kb1r/pp3ppp/2p1pn2/q4b2/2BP4/2N2N2/PPPB1PPP/R2QK2R w KQkq - 0 8",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/4k3/3p4/2R5/4K3/4P3/8 w - - 0 1",
+};
+
+// Perft throughput positions (the standard perft suite positions 1-5 plus an opening)
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    int depth;
+};
+
+const PerftCase perftCases[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5},
+    {"ruy_lopez", "r1bqk2r/1pppbppp/p1n2n2/4p3/B3P3/5N2/PPPP1PPP/RNBQ1RK1 w kq - 4 6", 4},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5},
+    {"promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4},
+    {"pos5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4},
+};
+
+const int benchDepth = 4;
+const int repeats = 5; // Throughput is the best of this many runs
+const int perftRepeats = 3;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<Board> loadBenchBoards() {
+    std::vector<Board> boards;
+    for (const char* fen : benchPositions) {
+        Board board;
+        board.setFromFEN(fen);
+        boards.push_back(board);
+    }
+    return boards;
+}
+
+// Runs fn() 'runs' times and returns the fastest wall time.
+template <typename Fn>
+double bestOf(Fn fn, int runs = repeats) {
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double elapsed = secondsSince(start);
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    return best > 0.0 ? best : 1e-9;
+}
+
+uint64_t benchNodes(int depth) {
+    Search search;
+    uint64_t nodes = 0;
+    for (Board& board : loadBenchBoards()) {
+        search.findBestMove(board, depth);
+        nodes += search.getNodesVisited();
+    }
+    return nodes;
+}
+
+} // namespace
+
+uint64_t Benchmark::perft(Board& board, int depth) {
+    if (depth == 0) return 1;
+
+    std::vector<Move> moves = board.generateLegalMoves();
+    if (depth == 1) return moves.size();
+
+    uint64_t nodes = 0;
+    for (const auto& move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove(move);
+    }
+    return nodes;
+}
+
+uint64_t Benchmark::perftDivide(Board& board, int depth, std::ostream& out) {
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& move : board.generateLegalMoves()) {
+        board.makeMove(move);
+        uint64_t nodes = depth > 1 ? perft(board, depth - 1) : 1;
+        board.unmakeMove(move);
+
+        out << squareToString(move.from) << squareToString(move.to);
+        if (move.isPromotion) out << " pnbrqk"[move.promotionPiece];
+        out << ": " << nodes << std::endl;
+        total += nodes;
+    }
+
+    double seconds = secondsSince(start);
+    out << "\nNodes: " << total << std::endl;
+    out << "Time: " << std::fixed << std::setprecision(3) << seconds << "s" << std::endl;
+    if (seconds > 0) out << "NPS: " << (uint64_t)(total / seconds) << std::endl;
+    return total;
+}
+
+void Benchmark::runBench(int depth, std::ostream& out) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = benchNodes(depth);
+    double seconds = secondsSince(start);
+
+    out << "===========================" << std::endl;
+    out << "Positions: " << std::size(benchPositions) << std::endl;
+    out << "Depth: " << depth << std::endl;
+    out << "Nodes searched: " << nodes << std::endl;
+    out << "Time: " << std::fixed << std::setprecision(3) << seconds << "s" << std::endl;
+    if (seconds > 0) out << "NPS: " << (uint64_t)(nodes / seconds) << std::endl;
+}
+
+void Benchmark::runSchedulerBench(int games, int threads, std::ostream& out) {
+    // One game per bench position and first move, so concurrent games differ
+    std::vector<Board> boards;
+    for (int i = 0; i < games; ++i) {
+        Board board;
+        board.setFromFEN(benchPositions[i % std::size(benchPositions)]);
+        std::vector<Move> moves = board.generateLegalMoves();
+        board.makeMove(moves[(i / std::size(benchPositions)) % moves.size()]);
+        boards.push_back(board);
+    }
+
+    // Blocking searches, one after another, each with a fresh table
+    auto start = std::chrono::steady_clock::now();
+    uint64_t blockingNodes = 0;
+    {
+        std::ostringstream discard;
+        auto table = std::make_shared<TranspositionTable>();
+        for (int i = 0; i < games; ++i) {
+            Search search;
+            search.setOutput(discard);
+            search.setTranspositionTable(table);
+            search.findBestMove(boards[i], benchDepth);
+            blockingNodes += search.getNodesVisited();
+        }
+    }
+    double blockingSeconds = secondsSince(start);
+
+    // The same searches submitted at once and interleaved by the scheduler
+    start = std::chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    std::vector<double> latencies;
+    int scheduledThreads;
+    {
+        SearchScheduler scheduler(threads);
+        scheduledThreads = scheduler.getThreadCount();
+        std::vector<std::future<ScheduledResult>> results;
+        ScheduledSearch options;
+        options.depth = benchDepth;
+        for (int i = 0; i < games; ++i) {
+            results.push_back(scheduler.submit(boards[i], options));
+        }
+        for (auto& result : results) {
+            ScheduledResult r = result.get();
+            nodes += r.nodes;
+            latencies.push_back(r.milliseconds);
+        }
+    }
+    double seconds = secondsSince(start);
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies[(size_t)(p * (latencies.size() - 1))]; };
+
+    out << "===========================" << std::endl;
+    out << "Games: " << games << " (depth " << benchDepth << ", " << scheduledThreads << " threads)" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    out << "Blocking:  " << blockingNodes << " nodes in " << blockingSeconds << "s, NPS "
+        << (uint64_t)(blockingNodes / blockingSeconds) << std::endl;
+    out << "Scheduled: " << nodes << " nodes in " << seconds << "s, NPS "
+        << (uint64_t)(nodes / seconds) << std::endl;
+    out << std::setprecision(1) << "Latency ms: p50 " << percentile(0.5) << " p95 " << percentile(0.95)
+        << " max " << latencies.back() << std::endl;
+}
+
+void Benchmark::runPerfSuite(std::ostream& json) {
+    std::vector<std::pair<std::string, uint64_t>> signature;
+    std::vector<std::pair<std::string, double>> throughput;
+
+    // Perft throughput
+    for (const auto& pc : perftCases) {
+        Board board;
+        board.setFromFEN(pc.fen);
+        uint64_t nodes = 0;
+        double seconds = bestOf([&] { nodes = perft(board, pc.depth); }, perftRepeats);
+        std::string name = std::string("perft.") + pc.name;
+        signature.emplace_back(name + ".d" + std::to_string(pc.depth), nodes);
+        throughput.emplace_back(name, nodes / seconds);
+    }
+
+    // Search over the bench positions
+    uint64_t nodes = 0;
+    double seconds = bestOf([&] { nodes = benchNodes(benchDepth); });
+    signature.emplace_back("bench.d" + std::to_string(benchDepth) + ".nodes", nodes);
+    throughput.emplace_back("bench", nodes / seconds);
+
+    // Microbenchmarks, each reported in operations per second
+    std::vector<Board> boards = loadBenchBoards();
+    const int iterations = 20000;
+
+    uint64_t ops = 0;
+    volatile size_t sink = 0;
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations; ++i)
+            for (Board& board : boards) { sink = sink + board.generateLegalMoves().size(); ++ops; }
+    });
+    throughput.emplace_back("micro.movegen", ops / seconds);
+
+    std::vector<std::vector<Move>> moveLists;
+    for (Board& board : boards) moveLists.push_back(board.generateLegalMoves());
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations; ++i) {
+            for (size_t b = 0; b < boards.size(); ++b) {
+                for (const auto& move : moveLists[b]) {
+                    if (boards[b].makeMove(move)) boards[b].unmakeMove(move);
+                    ++ops;
+                }
+            }
+        }
+    });
+    throughput.emplace_back("micro.make_unmake", ops / seconds);
+
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations * 10; ++i)
+            for (const Board& board : boards) { sink = sink + board.evaluate(); ++ops; }
+    });
+    throughput.emplace_back("micro.evaluate", ops / seconds);
+
+    // The same positions packed and scored in batches
+    std::vector<PackedPosition> packed;
+    for (int i = 0; i < 1024; ++i) packed.push_back(PackedPosition::pack(boards[i % boards.size()], 0, 1));
+    std::vector<int> scores(packed.size());
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations * 10 * (int)boards.size() / (int)packed.size(); ++i) {
+            BatchEval::evaluate(packed.data(), packed.size(), scores.data());
+            sink = sink + scores[i % scores.size()];
+            ops += packed.size();
+        }
+    });
+    throughput.emplace_back("micro.evaluate_batch", ops / seconds);
+
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations; ++i) {
+            for (const Board& board : boards) {
+                for (int sq = 0; sq < 64; ++sq) {
+                    sink = sink + board.isSquareAttacked(sq, WHITE) + board.isSquareAttacked(sq, BLACK);
+                    ops += 2;
+                }
+            }
+        }
+    });
+    throughput.emplace_back("micro.attacks", ops / seconds);
+
+    // SAN decoding and formatting of every legal move in the bench positions
+    std::vector<std::vector<std::string>> sanLists;
+    for (size_t b = 0; b < boards.size(); ++b) {
+        sanLists.emplace_back();
+        for (const auto& move : moveLists[b]) sanLists.back().push_back(PGNLoader::toSAN(move, boards[b]));
+    }
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations / 4; ++i) {
+            for (size_t b = 0; b < boards.size(); ++b) {
+                for (const auto& san : sanLists[b]) {
+                    sink = sink + PGNLoader::parseSAN(std::string_view(san), boards[b]).to;
+                    ++ops;
+                }
+            }
+        }
+    });
+    throughput.emplace_back("micro.san_parse", ops / seconds);
+
+    seconds = bestOf([&] {
+        ops = 0;
+        for (int i = 0; i < iterations / 20; ++i) {
+            for (size_t b = 0; b < boards.size(); ++b) {
+                for (const auto& move : moveLists[b]) {
+                    sink = sink + PGNLoader::toSAN(move, boards[b]).size();
+                    ++ops;
+                }
+            }
+        }
+    });
+    throughput.emplace_back("micro.san_format", ops / seconds);
+
+    json << "{\n  \"signature\": {\n";
+    for (size_t i = 0; i < signature.size(); ++i) {
+        json << "    \"" << signature[i].first << "\": " << signature[i].second
+             << (i + 1 < signature.size() ? ",\n" : "\n");
+    }
+    json << "  },\n  \"throughput\": {\n";
+    for (size_t i = 0; i < throughput.size(); ++i) {
+        json << "    \"" << throughput[i].first << "\": " << (uint64_t)throughput[i].second
+             << (i + 1 < throughput.size() ? ",\n" : "\n");
+    }
+    json << "  }\n}" << std::endl;
+}
+
+bool Benchmark::runEvalThroughput(const std::string& filename, std::ostream& out) {
+    MappedFile file;
+    if (!file.open(filename) || file.size() == 0 || file.size() % sizeof(PackedPosition) != 0) {
+        out << "Cannot read packed positions from " << filename << std::endl;
+        return false;
+    }
+    const PackedPosition* positions = reinterpret_cast<const PackedPosition*>(file.data());
+    size_t count = file.size() / sizeof(PackedPosition);
+
+    // One Board per position, as the search evaluates
+    std::vector<int> expected(count);
+    auto start = std::chrono::steady_clock::now();
+    Board board;
+    board.setVerbose(false);
+    for (size_t i = 0; i < count; ++i) {
+        positions[i].unpack(board);
+        expected[i] = board.evaluateMaterial();
+    }
+    double boardSeconds = secondsSince(start);
+
+    std::vector<int> scalar(count), batch(count);
+    double scalarSeconds = bestOf([&] { BatchEval::evaluateScalar(positions, count, scalar.data()); }, 3);
+    double batchSeconds = bestOf([&] { BatchEval::evaluate(positions, count, batch.data()); }, 3);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; ++i) mismatches += scalar[i] != expected[i] || batch[i] != expected[i];
+
+    out << "Positions: " << count << std::endl;
+    out << "Board material:  " << (uint64_t)(count / boardSeconds) << " positions/s (with unpacking)" << std::endl;
+    out << "Batch scalar:    " << (uint64_t)(count / scalarSeconds) << " positions/s" << std::endl;
+    out << "Batch " << BatchEval::kernelName() << ":" << std::string(10 - std::string(BatchEval::kernelName()).size(), ' ')
+        << (uint64_t)(count / batchSeconds) << " positions/s" << std::endl;
+    out << "Mismatches: " << mismatches << std::endl;
+    return mismatches == 0;
+}
+
+bool Benchmark::runPGNThroughput(const std::string& filename, bool replay, std::ostream& out) {
+    PGNReader reader;
+    if (!reader.open(filename)) {
+        out << "Cannot open " << filename << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t tokens = 0;
+    uint64_t errors = 0;
+
+    PGNGame game;
+    PGNToken token;
+    Board board;
+    while (reader.next(game)) {
+        ++games;
+        if (replay) board.setupStandardPosition();
+        bool failed = false;
+
+        PGNTokenizer tokenizer(game.movetext);
+        while (tokenizer.next(token)) {
+            ++tokens;
+            if (token.type != PGN_MOVE || token.depth != 0) continue;
+            ++moves;
+            if (replay && !failed) {
+                Move move = PGNLoader::parseSAN(token.text, board);
+                if (move.from == -1 || !board.makeMove(move)) {
+                    failed = true;
+                    ++errors;
+                }
+            }
+        }
+    }
+
+    double seconds = secondsSince(start);
+    double mb = reader.size() / (1024.0 * 1024.0);
+    out << "Games: " << games << std::endl;
+    out << "Moves: " << moves << " (" << tokens << " tokens)" << std::endl;
+    if (replay) out << "Games with unplayable moves: " << errors << std::endl;
+    out << "Size: " << std::fixed << std::setprecision(1) << mb << " MB" << std::endl;
+    out << "Time: " << std::setprecision(3) << seconds << "s" << std::endl;
+    if (seconds > 0) {
+        out << "Games/s: " << (uint64_t)(games / seconds) << std::endl;
+        out << "MB/s: " << std::setprecision(1) << (mb / seconds) << std::endl;
+        if (replay) out << "Moves/s: " << (uint64_t)(moves / seconds) << std::endl;
+    }
+    return true;
+}
@@ -1,13 +1,137 @@
 #include "Board.h"
+#include "EvalTables.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <cmath>
 
-Board::Board() : turn(WHITE), verbose(false), enPassantSquare(-1), castlingRights(0) {
+// --- Zobrist Hashing ---
+
+namespace {
+
+struct ZobristKeys {
+    uint64_t pieces[24][64]; // Indexed by piece value (color | type)
+    uint64_t castling[16];
+    uint64_t enPassantFile[8];
+    uint64_t side;           // XORed in when Black is to move
+};
+
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x4F6374616E74ULL; // "Octant"
+    for (auto& piece : keys.pieces)
+        for (auto& key : piece) key = splitMix64(state);
+    // An empty square hashes to nothing, so make/unmake need not test for it
+    for (auto& key : keys.pieces[EMPTY]) key = 0;
+    for (auto& key : keys.castling) key = splitMix64(state);
+    for (auto& key : keys.enPassantFile) key = splitMix64(state);
+    keys.side = splitMix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys zobrist = makeZobristKeys();
+
+// Castling rights kept after a move from or to each square: moving the king
+// or a rook, or capturing a rook, gives up the rights that depend on it
+constexpr int castlingKeep[64] = {
+    13, 15, 15, 15, 12, 15, 15, 14,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     7, 15, 15, 15,  3, 15, 15, 11,
+};
+
+// Squares attacked from each square, for Board::computeAttacks and
+// Board::isSquareAttacked
+struct AttackTables {
+    uint64_t knight[64];
+    uint64_t king[64];
+    uint64_t pawn[2][64]; // Squares a pawn of each side attacks
+    uint64_t rays[64][8]; // Outwards, in the order of 'directions'
+
+    // Diagonals first, then lines. Directions 2, 3, 5 and 7 go up the board.
+    static constexpr int directions[8][2] = {{-1,-1}, {-1,1}, {1,-1}, {1,1}, {-1,0}, {1,0}, {0,-1}, {0,1}};
+    static bool upwards(int d) { return d == 2 || d == 3 || d == 5 || d == 7; }
+
+    AttackTables() {
+        const int knightOffsets[8][2] = {{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}};
+        auto bit = [](int r, int f) { return r >= 0 && r < 8 && f >= 0 && f < 8 ? 1ULL << (r * 8 + f) : 0; };
+        for (int square = 0; square < 64; ++square) {
+            int rank = square / 8;
+            int file = square % 8;
+            pawn[0][square] = bit(rank + 1, file - 1) | bit(rank + 1, file + 1);
+            pawn[1][square] = bit(rank - 1, file - 1) | bit(rank - 1, file + 1);
+            knight[square] = king[square] = 0;
+            for (int i = 0; i < 8; ++i) {
+                knight[square] |= bit(rank + knightOffsets[i][0], file + knightOffsets[i][1]);
+                king[square] |= bit(rank + directions[i][0], file + directions[i][1]);
+                rays[square][i] = 0;
+                for (int step = 1; step < 8; ++step) rays[square][i] |= bit(rank + step * directions[i][0], file + step * directions[i][1]);
+            }
+        }
+    }
+
+    // Squares attacked along direction d up to and including the first
+    // blocker. Without one, the edge square stands in: no ray leaves it in
+    // that direction.
+    uint64_t ray(int square, int d, uint64_t occupied) const {
+        uint64_t blockers = rays[square][d] & occupied;
+        int first = upwards(d) ? __builtin_ctzll(blockers | 1ULL << 63) : 63 - __builtin_clzll(blockers | 1);
+        return rays[square][d] ^ rays[first][d];
+    }
+};
+
+const AttackTables& attackTables() {
+    static const AttackTables tables;
+    return tables;
+}
+
+// Material plus square table entry of each piece (color | type) on each
+// square, negated for Black
+struct MaterialWeights {
+    int value[24][64] = {};
+
+    MaterialWeights() {
+        for (int type = PAWN; type <= KING; ++type) {
+            for (int square = 0; square < 64; ++square) {
+                value[WHITE | type][square] = pieceValues[type] + pieceSquareTables[type][square];
+                value[BLACK | type][square] = -(pieceValues[type] + pieceSquareTables[type][square ^ 56]);
+            }
+        }
+    }
+};
+
+const MaterialWeights& materialWeights() {
+    static const MaterialWeights weights;
+    return weights;
+}
+
+// Builds without -mpopcnt would call into libgcc for __builtin_popcountll
+inline int countBits(uint64_t bits) {
+    bits -= (bits >> 1) & 0x5555555555555555ULL;
+    bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((bits * 0x0101010101010101ULL) >> 56);
+}
+
+} // namespace
+
+Board::Board() : turn(WHITE), verbose(false), enPassantSquare(-1), castlingRights(0), halfMoveClock(0), fullMoveNumber(1), hash(0), material(0), occupancy(0) {
     for (int i = 0; i < 64; ++i) {
         squares[i] = EMPTY;
     }
     setupStandardPosition();
+    attacks.key = ~hash;
 }
 
 Board::~Board() {
@@ -24,6 +148,9 @@ void Board::log(const std::string& message) const {
 }
 
 void Board::setupStandardPosition() {
+    for (int i = 16; i < 48; ++i) squares[i] = EMPTY;
+    history.clear();
+
     // White pieces
     squares[0] = makePiece(WHITE, ROOK);
     squares[1] = makePiece(WHITE, KNIGHT);
@@ -49,9 +176,129 @@ void Board::setupStandardPosition() {
     turn = WHITE;
     castlingRights = 0xF; // All castling allowed
     enPassantSquare = -1;
+    halfMoveClock = 0;
+    fullMoveNumber = 1;
+    hash = computeHash();
+    material = computeMaterial();
+    occupancy = computeOccupancy();
     log("Standard position setup complete.");
 }
 
+bool Board::setFromFEN(std::string_view fen) {
+    int newSquares[64];
+    size_t pos = 0;
+    const size_t n = fen.size();
+
+    auto skipSpaces = [&]() {
+        while (pos < n && fen[pos] == ' ') ++pos;
+    };
+    // Reads a non-negative integer field; returns 'fallback' if the field is missing
+    auto readNumber = [&](int fallback, int& value) {
+        skipSpaces();
+        if (pos >= n) { value = fallback; return true; }
+        if (fen[pos] < '0' || fen[pos] > '9') return false;
+        value = 0;
+        while (pos < n && fen[pos] >= '0' && fen[pos] <= '9') value = value * 10 + (fen[pos++] - '0');
+        return true;
+    };
+
+    // 1. Piece placement, rank 8 first
+    skipSpaces();
+    int rank = 7;
+    int file = 0;
+    int kings[2] = {0, 0};
+    for (int i = 0; i < 64; ++i) newSquares[i] = EMPTY;
+    for (; pos < n && fen[pos] != ' '; ++pos) {
+        char c = fen[pos];
+        if (c == '/') {
+            if (file != 8 || rank == 0) return false;
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) return false;
+        } else {
+            PieceType type;
+            switch (c | 0x20) { // Lowercase
+                case 'p': type = PAWN; break;
+                case 'n': type = KNIGHT; break;
+                case 'b': type = BISHOP; break;
+                case 'r': type = ROOK; break;
+                case 'q': type = QUEEN; break;
+                case 'k': type = KING; break;
+                default: return false;
+            }
+            if (file >= 8) return false;
+            PieceColor color = (c >= 'a') ? BLACK : WHITE;
+            if (type == KING) kings[color == WHITE ? 0 : 1]++;
+            newSquares[rank * 8 + file++] = makePiece(color, type);
+        }
+    }
+    if (rank != 0 || file != 8 || kings[0] != 1 || kings[1] != 1) return false;
+
+    // 2. Side to move
+    skipSpaces();
+    if (pos >= n || (fen[pos] != 'w' && fen[pos] != 'b')) return false;
+    int newTurn = fen[pos++] == 'w' ? WHITE : BLACK;
+
+    // 3. Castling rights
+    skipSpaces();
+    int newCastling = 0;
+    if (pos < n && fen[pos] == '-') {
+        ++pos;
+    } else {
+        for (; pos < n && fen[pos] != ' '; ++pos) {
+            switch (fen[pos]) {
+                case 'K': newCastling |= 1; break;
+                case 'Q': newCastling |= 2; break;
+                case 'k': newCastling |= 4; break;
+                case 'q': newCastling |= 8; break;
+                default: return false;
+            }
+        }
+    }
+    // Drop rights that the piece placement contradicts
+    if (newSquares[4] != makePiece(WHITE, KING)) newCastling &= ~0x3;
+    if (newSquares[60] != makePiece(BLACK, KING)) newCastling &= ~0xC;
+    if (newSquares[7] != makePiece(WHITE, ROOK)) newCastling &= ~1;
+    if (newSquares[0] != makePiece(WHITE, ROOK)) newCastling &= ~2;
+    if (newSquares[63] != makePiece(BLACK, ROOK)) newCastling &= ~4;
+    if (newSquares[56] != makePiece(BLACK, ROOK)) newCastling &= ~8;
+
+    // 4. En passant target square
+    skipSpaces();
+    int newEnPassant = -1;
+    if (pos < n && fen[pos] == '-') {
+        ++pos;
+    } else if (pos + 1 < n) {
+        int f = fen[pos] - 'a';
+        int r = fen[pos + 1] - '1';
+        if (f < 0 || f > 7 || (r != 2 && r != 5)) return false;
+        newEnPassant = r * 8 + f;
+        pos += 2;
+    } else {
+        return false;
+    }
+
+    // 5./6. Halfmove clock and fullmove number (optional)
+    int newHalfMove = 0;
+    int newFullMove = 1;
+    if (!readNumber(0, newHalfMove) || !readNumber(1, newFullMove)) return false;
+
+    for (int i = 0; i < 64; ++i) squares[i] = newSquares[i];
+    turn = newTurn;
+    castlingRights = newCastling;
+    enPassantSquare = newEnPassant;
+    halfMoveClock = newHalfMove;
+    fullMoveNumber = newFullMove > 0 ? newFullMove : 1;
+    history.clear();
+    hash = computeHash();
+    material = computeMaterial();
+    occupancy = computeOccupancy();
+    log("Position set from FEN.");
+    return true;
+}
+
 char getPieceChar(int piece) {
     int type = piece & 0x7;
     int color = piece & 0x18;
@@ -72,26 +319,78 @@ char getPieceChar(int piece) {
     return c;
 }
 
-void Board::printBoard() const {
-    std::cout << "  +-----------------+" << std::endl;
+void Board::printBoard(std::ostream& out) const {
+    out << "  +-----------------+" << std::endl;
     for (int rank = 7; rank >= 0; --rank) {
-        std::cout << rank + 1 << " | ";
+        out << rank + 1 << " | ";
         for (int file = 0; file < 8; ++file) {
             int square = rank * 8 + file;
-            std::cout << getPieceChar(squares[square]) << " ";
+            out << getPieceChar(squares[square]) << " ";
         }
-        std::cout << "|" << std::endl;
+        out << "|" << std::endl;
     }
-    std::cout << "  +-----------------+" << std::endl;
-    std::cout << "    a b c d e f g h" << std::endl;
-    std::cout << "Turn: " << (turn == WHITE ? "White" : "Black") << std::endl;
-    std::cout << "Castling: " << ((castlingRights & 1) ? "K" : "") << ((castlingRights & 2) ? "Q" : "") 
+    out << "  +-----------------+" << std::endl;
+    out << "    a b c d e f g h" << std::endl;
+    out << "Turn: " << (turn == WHITE ? "White" : "Black") << std::endl;
+    out << "Castling: " << ((castlingRights & 1) ? "K" : "") << ((castlingRights & 2) ? "Q" : "") 
               << ((castlingRights & 4) ? "k" : "") << ((castlingRights & 8) ? "q" : "") << std::endl;
     if (enPassantSquare != -1) {
         int f = enPassantSquare % 8;
         int r = enPassantSquare / 8;
-        std::cout << "EP Target: " << (char)('a' + f) << (r + 1) << std::endl;
+        out << "EP Target: " << (char)('a' + f) << (r + 1) << std::endl;
+    }
+    out << "FEN: " << toFEN() << std::endl;
+}
+
+uint64_t Board::computeHash() const {
+    uint64_t h = 0;
+    for (int i = 0; i < 64; ++i) {
+        if (squares[i] != EMPTY) h ^= zobrist.pieces[squares[i]][i];
+    }
+    h ^= zobrist.castling[castlingRights];
+    if (enPassantSquare != -1) h ^= zobrist.enPassantFile[enPassantSquare % 8];
+    if (turn == BLACK) h ^= zobrist.side;
+    return h;
+}
+
+std::string Board::toFEN() const {
+    std::string fen;
+    fen.reserve(90);
+
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            int piece = squares[rank * 8 + file];
+            if (piece == EMPTY) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) fen += (char)('0' + empty);
+            empty = 0;
+            fen += getPieceChar(piece);
+        }
+        if (empty > 0) fen += (char)('0' + empty);
+        if (rank > 0) fen += '/';
     }
+
+    fen += (turn == WHITE) ? " w " : " b ";
+
+    if (castlingRights == 0) fen += '-';
+    if (castlingRights & 1) fen += 'K';
+    if (castlingRights & 2) fen += 'Q';
+    if (castlingRights & 4) fen += 'k';
+    if (castlingRights & 8) fen += 'q';
+
+    fen += ' ';
+    if (enPassantSquare == -1) {
+        fen += '-';
+    } else {
+        fen += (char)('a' + enPassantSquare % 8);
+        fen += (char)('1' + enPassantSquare / 8);
+    }
+
+    fen += ' ' + std::to_string(halfMoveClock) + ' ' + std::to_string(fullMoveNumber);
+    return fen;
 }
 
 int Board::getPieceAt(int square) const {
@@ -126,86 +425,121 @@ bool Board::isPathClear(int from, int to) const {
 }
 
 bool Board::isSquareAttacked(int square, int attackerColor) const {
-    int rank = square / 8;
-    int file = square % 8;
+    const AttackTables& tables = attackTables();
+    int side = attackerColor == WHITE ? 0 : 1;
 
-    // Check Pawn attacks
-    int pawnDir = (attackerColor == WHITE) ? -1 : 1; // Pawns attack "backwards" from target perspective
-    // If we are checking if White attacks 'square', we look for White pawns at square - 1 rank
-    // Wait, simpler: Iterate all squares? No, too slow.
-    // Check possible source squares for the attacker.
-    
-    // Check for Pawns
-    int pawnRank = rank - ((attackerColor == WHITE) ? 1 : -1);
-    if (pawnRank >= 0 && pawnRank < 8) {
-        if (file - 1 >= 0) {
-            int p = squares[pawnRank * 8 + (file - 1)];
-            if ((p & 0x18) == attackerColor && (p & 0x7) == PAWN) return true;
-        }
-        if (file + 1 < 8) {
-            int p = squares[pawnRank * 8 + (file + 1)];
-            if ((p & 0x18) == attackerColor && (p & 0x7) == PAWN) return true;
-        }
-    }
+    // Pawns, knights and king: look at the occupied squares they would attack
+    // from. An attacking pawn stands where a defending pawn on 'square' attacks.
+    bool found = false;
+    for (uint64_t bits = tables.pawn[1 - side][square] & occupancy; bits != 0; bits &= bits - 1)
+        found |= squares[__builtin_ctzll(bits)] == (attackerColor | PAWN);
+    for (uint64_t bits = tables.knight[square] & occupancy; bits != 0; bits &= bits - 1)
+        found |= squares[__builtin_ctzll(bits)] == (attackerColor | KNIGHT);
+    for (uint64_t bits = tables.king[square] & occupancy; bits != 0; bits &= bits - 1)
+        found |= squares[__builtin_ctzll(bits)] == (attackerColor | KING);
+    if (found) return true;
 
-    // Check Knights
-    int kMoves[8][2] = {{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}};
-    for (auto& m : kMoves) {
-        int r = rank + m[0];
-        int f = file + m[1];
-        if (r >= 0 && r < 8 && f >= 0 && f < 8) {
-            int p = squares[r * 8 + f];
-            if ((p & 0x18) == attackerColor && (p & 0x7) == KNIGHT) return true;
-        }
+    // Sliders: the first piece along each ray
+    for (int d = 0; d < 8; ++d) {
+        uint64_t blockers = tables.rays[square][d] & occupancy;
+        if (blockers == 0) continue;
+        int target = squares[AttackTables::upwards(d) ? __builtin_ctzll(blockers) : 63 - __builtin_clzll(blockers)];
+        if ((target & 0x18) != attackerColor) continue;
+        int type = target & 0x7;
+        if (type == QUEEN || type == (d < 4 ? BISHOP : ROOK)) return true;
     }
 
-    // Check Kings
-    int kingMoves[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
-    for (auto& m : kingMoves) {
-        int r = rank + m[0];
-        int f = file + m[1];
-        if (r >= 0 && r < 8 && f >= 0 && f < 8) {
-            int p = squares[r * 8 + f];
-            if ((p & 0x18) == attackerColor && (p & 0x7) == KING) return true;
-        }
-    }
+    return false;
+}
 
-    // Check Sliding Pieces (Rook/Queen)
-    int rookDirs[4][2] = {{-1,0}, {1,0}, {0,-1}, {0,1}};
-    for (auto& d : rookDirs) {
-        int r = rank + d[0];
-        int f = file + d[1];
-        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
-            int p = squares[r * 8 + f];
-            if (p != EMPTY) {
-                if ((p & 0x18) == attackerColor && ((p & 0x7) == ROOK || (p & 0x7) == QUEEN)) return true;
-                break; // Blocked
-            }
-            r += d[0];
-            f += d[1];
+const AttackMap& Board::getAttacks() const {
+    if (attacks.key != hash) computeAttacks(attacks);
+    return attacks;
+}
+
+void Board::computeAttacks(AttackMap& map) const {
+    const AttackTables& tables = attackTables();
+
+    // Bitboard per piece value (color | type), without branching on each square
+    uint64_t byPiece[24] = {};
+    for (int square = 0; square < 64; ++square) byPiece[squares[square]] |= 1ULL << square;
+    uint64_t byType[2][7];
+    for (int side = 0; side < 2; ++side) {
+        map.occupied[side] = 0;
+        for (int type = PAWN; type <= KING; ++type) {
+            byType[side][type] = byPiece[(side == 0 ? WHITE : BLACK) | type];
+            map.occupied[side] |= byType[side][type];
         }
+        map.pieces[side] = map.occupied[side] & ~byType[side][PAWN] & ~byType[side][KING];
+        map.kingSquares[side] = byType[side][KING] ? __builtin_ctzll(byType[side][KING]) : -1;
     }
+    uint64_t occupied = map.occupied[0] | map.occupied[1];
 
-    // Check Sliding Pieces (Bishop/Queen)
-    int bishopDirs[4][2] = {{-1,-1}, {-1,1}, {1,-1}, {1,1}};
-    for (auto& d : bishopDirs) {
-        int r = rank + d[0];
-        int f = file + d[1];
-        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
-            int p = squares[r * 8 + f];
-            if (p != EMPTY) {
-                if ((p & 0x18) == attackerColor && ((p & 0x7) == BISHOP || (p & 0x7) == QUEEN)) return true;
-                break; // Blocked
+    for (int side = 0; side < 2; ++side) {
+        // Zone of the enemy king, for counting attacks on it
+        int enemyKing = map.kingSquares[1 - side];
+        uint64_t zone = enemyKing >= 0 ? tables.king[enemyKing] | 1ULL << enemyKing : 0;
+        int zoneAttacks = 0;
+
+        // All pawns at once: towards the a-file and towards the h-file
+        const uint64_t notFileA = 0xFEFEFEFEFEFEFEFEULL;
+        const uint64_t notFileH = 0x7F7F7F7F7F7F7F7FULL;
+        uint64_t pawns = byType[side][PAWN];
+        uint64_t left = side == 0 ? (pawns & notFileA) << 7 : (pawns & notFileA) >> 9;
+        uint64_t right = side == 0 ? (pawns & notFileH) << 9 : (pawns & notFileH) >> 7;
+        map.pawnAttacks[side] = left | right;
+        uint64_t attacked = left | right;
+        zoneAttacks += countBits(left & zone) + countBits(right & zone);
+
+        map.mobility[side][PAWN] = 0;
+        for (int type = KNIGHT; type <= KING; ++type) {
+            int mobility = 0;
+            for (uint64_t bits = byType[side][type]; bits != 0; bits &= bits - 1) {
+                int square = __builtin_ctzll(bits);
+                uint64_t attacks = 0;
+                if (type == KNIGHT) attacks = tables.knight[square];
+                else if (type == KING) attacks = tables.king[square];
+                else {
+                    if (type != ROOK)
+                        for (int d = 0; d < 4; ++d) attacks |= tables.ray(square, d, occupied);
+                    if (type != BISHOP)
+                        for (int d = 4; d < 8; ++d) attacks |= tables.ray(square, d, occupied);
+                }
+                attacked |= attacks;
+                mobility += countBits(attacks & ~map.occupied[side]);
+                if (attacks & zone) zoneAttacks += countBits(attacks & zone);
             }
-            r += d[0];
-            f += d[1];
+            map.mobility[side][type] = mobility;
         }
+        map.attacked[side] = attacked;
+        map.kingZoneAttacks[1 - side] = zoneAttacks;
     }
 
-    return false;
+    // Pins: an own piece between the king and an enemy slider on its line
+    map.pinned = 0;
+    map.key = hash;
+    int us = turn == WHITE ? 0 : 1;
+    int king = map.kingSquares[us];
+    if (king < 0) return;
+    for (int d = 0; d < 8; ++d) {
+        uint64_t blocker = tables.ray(king, d, occupied) & map.occupied[us];
+        if (blocker == 0) continue;
+        int square = __builtin_ctzll(blocker);
+        uint64_t beyond = tables.ray(square, d, occupied) & map.occupied[1 - us];
+        if (beyond == 0) continue;
+        int type = squares[__builtin_ctzll(beyond)] & 0x7;
+        if (type == QUEEN || type == (d < 4 ? BISHOP : ROOK)) map.pinned |= blocker;
+    }
 }
 
 bool Board::isInCheck(int color) const {
+    // The attack map answers for free when it is up to date
+    if (attacks.key == hash) {
+        int side = color == WHITE ? 0 : 1;
+        int king = attacks.kingSquares[side];
+        return king >= 0 && attacks.isAttacked(king, color == WHITE ? BLACK : WHITE);
+    }
+
     // Find King
     int kingSquare = -1;
     for (int i = 0; i < 64; ++i) {
@@ -221,6 +555,15 @@ bool Board::isInCheck(int color) const {
     return isSquareAttacked(kingSquare, enemyColor);
 }
 
+bool Board::hasInsufficientMaterial() const {
+    if (__builtin_popcountll(occupancy) > 3) return false; // Two kings and more than one piece
+    for (uint64_t bits = occupancy; bits != 0; bits &= bits - 1) {
+        int type = squares[__builtin_ctzll(bits)] & 0x7;
+        if (type == PAWN || type == ROOK || type == QUEEN) return false;
+    }
+    return true;
+}
+
 bool Board::validatePawnMove(int from, int to, int piece, int target) const {
     int color = piece & 0x18;
     int direction = (color == WHITE) ? 1 : -1;
@@ -559,31 +902,35 @@ void Board::generateKingMoves(int square, std::vector<Move>& moves) const {
     }
     
     // Castling
-    // Note: We only check structural legality here (rights + path). 
-    // "Through check" is handled by makeMove/isValidMove check.
+    // The king may not start on, pass or land on an attacked square
+    const AttackMap& map = getAttacks();
+    auto safe = [&](int a, int b, int c) {
+        int enemy = color == WHITE ? BLACK : WHITE;
+        return !map.isAttacked(a, enemy) && !map.isAttacked(b, enemy) && !map.isAttacked(c, enemy);
+    };
     if (color == WHITE) {
         if (castlingRights & 1) { // WK
             if (squares[5] == EMPTY && squares[6] == EMPTY) {
-                if (!isSquareAttacked(4, BLACK) && !isSquareAttacked(5, BLACK) && !isSquareAttacked(6, BLACK))
+                if (safe(4, 5, 6))
                     moves.emplace_back(square, 6, piece, 0, true);
             }
         }
         if (castlingRights & 2) { // WQ
             if (squares[1] == EMPTY && squares[2] == EMPTY && squares[3] == EMPTY) {
-                if (!isSquareAttacked(4, BLACK) && !isSquareAttacked(3, BLACK) && !isSquareAttacked(2, BLACK))
+                if (safe(4, 3, 2))
                     moves.emplace_back(square, 2, piece, 0, true);
             }
         }
     } else {
         if (castlingRights & 4) { // BK
             if (squares[61] == EMPTY && squares[62] == EMPTY) {
-                if (!isSquareAttacked(60, WHITE) && !isSquareAttacked(61, WHITE) && !isSquareAttacked(62, WHITE))
+                if (safe(60, 61, 62))
                     moves.emplace_back(square, 62, piece, 0, true);
             }
         }
         if (castlingRights & 8) { // BQ
             if (squares[57] == EMPTY && squares[58] == EMPTY && squares[59] == EMPTY) {
-                if (!isSquareAttacked(60, WHITE) && !isSquareAttacked(59, WHITE) && !isSquareAttacked(58, WHITE))
+                if (safe(60, 59, 58))
                     moves.emplace_back(square, 58, piece, 0, true);
             }
         }
@@ -593,6 +940,7 @@ void Board::generateKingMoves(int square, std::vector<Move>& moves) const {
 std::vector<Move> Board::generateLegalMoves() {
     std::vector<Move> moves;
     moves.reserve(50); // Pre-allocate some space
+    const AttackMap& map = getAttacks();
     
     for (int i = 0; i < 64; ++i) {
         int piece = squares[i];
@@ -621,39 +969,88 @@ std::vector<Move> Board::generateLegalMoves() {
         }
     }
     
-    // Filter illegal moves (those that leave King in check)
-    std::vector<Move> legalMoves;
-    legalMoves.reserve(moves.size());
-    
-    for (const auto& move : moves) {
-        if (makeMove(move)) {
-            legalMoves.push_back(move);
-            unmakeMove(move);
+    // Filter illegal moves (those that leave King in check). Out of check,
+    // a king move is legal if its target is not attacked (castling was
+    // checked by generateKingMoves) and any other move if the piece is not
+    // pinned. Moves in check, pinned pieces and en passant are played out.
+    int us = turn == WHITE ? 0 : 1;
+    int king = map.kingSquares[us];
+    int enemy = turn == WHITE ? BLACK : WHITE;
+    bool inCheck = king >= 0 && map.isAttacked(king, enemy);
+    moves.erase(std::remove_if(moves.begin(), moves.end(), [&](const Move& move) {
+        if (!inCheck) {
+            if (move.from == king) return !move.isCastling && map.isAttacked(move.to, enemy);
+            bool enPassant = (move.piece & 0x7) == PAWN && move.to == enPassantSquare;
+            if (!enPassant && !((map.pinned >> move.from) & 1)) return false;
         }
-    }
+        if (!makeMove(move)) return true;
+        unmakeMove(move);
+        return false;
+    }), moves.end());
     
-    return legalMoves;
+    return moves;
 }
 
 // --- Move Execution ---
 
 bool Board::makeMove(int from, int to) {
     // Legacy wrapper for UI
-    // We need to construct a proper Move object to use the new system
-    // This is inefficient but fine for UI
-    std::vector<Move> moves = generateLegalMoves();
-    for (const auto& m : moves) {
-        if (m.from == from && m.to == to) {
-            // Found a matching legal move.
-            // If it's a promotion, we default to Queen for this simple UI
-            if (m.isPromotion && m.promotionPiece != QUEEN) continue;
-            
-            makeMove(m);
-            return true;
+    // Promotions default to Queen for this simple UI
+    if (!isValidMove(from, to)) {
+        log("Move not valid.");
+        return false;
+    }
+    if (!makeMove(buildMove(from, to, QUEEN))) {
+        log("Move leaves the king in check.");
+        return false;
+    }
+    return true;
+}
+
+Move Board::buildMove(int from, int to, int promotionPiece) const {
+    int piece = squares[from];
+    int type = piece & 0x7;
+    int captured = squares[to];
+
+    if (type == PAWN) {
+        if (to == enPassantSquare && captured == EMPTY) {
+            captured = squares[(piece & 0x18) == WHITE ? to - 8 : to + 8];
+        }
+        if (to / 8 == 0 || to / 8 == 7) {
+            return Move(from, to, piece, captured, false, true, promotionPiece ? promotionPiece : QUEEN);
         }
     }
-    log("Move not found in legal moves list.");
-    return false;
+    bool castling = type == KING && std::abs(to - from) == 2;
+    return Move(from, to, piece, captured, castling);
+}
+
+Move Board::parseUciMove(std::string_view uci) const {
+    if (uci.length() < 4 || uci.length() > 5) return Move();
+
+    int fromFile = uci[0] - 'a', fromRank = uci[1] - '1';
+    int toFile = uci[2] - 'a', toRank = uci[3] - '1';
+    if (fromFile < 0 || fromFile > 7 || fromRank < 0 || fromRank > 7 ||
+        toFile < 0 || toFile > 7 || toRank < 0 || toRank > 7) {
+        return Move();
+    }
+    int from = fromRank * 8 + fromFile;
+    int to = toRank * 8 + toFile;
+
+    int promotion = 0;
+    if (uci.length() == 5) {
+        switch (uci[4]) {
+            case 'q': promotion = QUEEN; break;
+            case 'r': promotion = ROOK; break;
+            case 'b': promotion = BISHOP; break;
+            case 'n': promotion = KNIGHT; break;
+            default: return Move();
+        }
+        bool promotes = (squares[from] & 0x7) == PAWN && (toRank == 0 || toRank == 7);
+        if (!promotes) return Move();
+    }
+
+    if (!isValidMove(from, to)) return Move();
+    return buildMove(from, to, promotion);
 }
 
 bool Board::makeMove(const Move& move) {
@@ -662,12 +1059,21 @@ bool Board::makeMove(const Move& move) {
     state.enPassantSquare = enPassantSquare;
     state.castlingRights = castlingRights;
     state.capturedPiece = move.capturedPiece; // Note: For EP, this might need adjustment if we want strict history
-    state.halfMoveClock = 0; // TODO
+    state.halfMoveClock = halfMoveClock;
+    state.hash = hash;
+    state.material = material;
+    state.occupancy = occupancy;
     history.push_back(state);
 
+    // Hash and material: remove the moving piece and anything on the target square
+    const MaterialWeights& weights = materialWeights();
+    hash ^= zobrist.pieces[squares[move.from]][move.from] ^ zobrist.pieces[squares[move.to]][move.to];
+    material -= weights.value[squares[move.from]][move.from] + weights.value[squares[move.to]][move.to];
+
     // Apply move
     squares[move.to] = squares[move.from];
     squares[move.from] = EMPTY;
+    occupancy = (occupancy & ~(1ULL << move.from)) | 1ULL << move.to;
     
     // Captures
     if (move.capturedPiece != EMPTY) {
@@ -685,43 +1091,58 @@ bool Board::makeMove(const Move& move) {
         else if (move.to == 2) { squares[3] = squares[0]; squares[0] = EMPTY; } // WQ
         else if (move.to == 62) { squares[61] = squares[63]; squares[63] = EMPTY; } // BK
         else if (move.to == 58) { squares[59] = squares[56]; squares[56] = EMPTY; } // BQ
+
+        int rook = makePiece((PieceColor)turn, ROOK);
+        int rookFrom = (move.to % 8 == 6) ? move.to + 1 : move.to - 2;
+        int rookTo = (move.to % 8 == 6) ? move.to - 1 : move.to + 1;
+        hash ^= zobrist.pieces[rook][rookFrom] ^ zobrist.pieces[rook][rookTo];
+        occupancy ^= 1ULL << rookFrom | 1ULL << rookTo;
+        material += weights.value[rook][rookTo] - weights.value[rook][rookFrom];
     }
+    hash ^= zobrist.pieces[squares[move.to]][move.to];
+    material += weights.value[squares[move.to]][move.to];
     
     // En Passant Capture
     // If we moved a pawn to the EP square, the captured pawn is "behind" the move.to
     if ((move.piece & 0x7) == PAWN && move.to == enPassantSquare) {
         int captureSquare = (turn == WHITE) ? (move.to - 8) : (move.to + 8);
+        hash ^= zobrist.pieces[squares[captureSquare]][captureSquare];
+        material -= weights.value[squares[captureSquare]][captureSquare];
         squares[captureSquare] = EMPTY;
+        occupancy &= ~(1ULL << captureSquare);
     }
     
     // Update State
     // En Passant Target
+    if (enPassantSquare != -1) hash ^= zobrist.enPassantFile[enPassantSquare % 8];
     enPassantSquare = -1;
     if ((move.piece & 0x7) == PAWN && std::abs(move.to - move.from) == 16) {
         enPassantSquare = (move.from + move.to) / 2;
+        hash ^= zobrist.enPassantFile[enPassantSquare % 8];
     }
     
     // Castling Rights
-    if ((move.piece & 0x7) == KING) {
-        if (turn == WHITE) castlingRights &= ~0x3;
-        else castlingRights &= ~0xC;
-    }
-    // Rook moves or captures
-    auto clearCorner = [&](int sq) {
-        if (sq == 0) castlingRights &= ~2;
-        if (sq == 7) castlingRights &= ~1;
-        if (sq == 56) castlingRights &= ~8;
-        if (sq == 63) castlingRights &= ~4;
-    };
-    clearCorner(move.from);
-    clearCorner(move.to);
+    int newCastlingRights = castlingRights & castlingKeep[move.from] & castlingKeep[move.to];
+    if (newCastlingRights != castlingRights) {
+        hash ^= zobrist.castling[castlingRights] ^ zobrist.castling[newCastlingRights];
+        castlingRights = newCastlingRights;
+    }
+    hash ^= zobrist.side;
+    
+    // Move counters. Updated before the legality check because the illegal
+    // path below goes through unmakeMove, which restores them.
+    if ((move.piece & 0x7) == PAWN || move.capturedPiece != EMPTY) halfMoveClock = 0;
+    else halfMoveClock++;
+    if (turn == BLACK) fullMoveNumber++;
     
     // Check legality
     if (isInCheck(turn)) {
         // Illegal move!
         // We must undo manually since we modified state
         // But wait, unmakeMove relies on history.
-        // We can just call unmakeMove.
+        // We can just call unmakeMove, but it expects the side to move
+        // to have been switched already.
+        turn = (turn == WHITE) ? BLACK : WHITE;
         unmakeMove(move);
         return false;
     }
@@ -740,6 +1161,11 @@ void Board::unmakeMove(const Move& move) {
     
     enPassantSquare = state.enPassantSquare;
     castlingRights = state.castlingRights;
+    halfMoveClock = state.halfMoveClock;
+    hash = state.hash;
+    material = state.material;
+    occupancy = state.occupancy;
+    if (turn == BLACK) fullMoveNumber--;
     
     // Reverse move
     squares[move.from] = move.piece;
@@ -766,139 +1192,54 @@ void Board::unmakeMove(const Move& move) {
 
 // --- Evaluation ---
 
-// --- Evaluation ---
+namespace {
 
-// Piece-Square Tables (PST)
-// Values are from White's perspective. Mirror for Black.
-// Flip rank for Black (rank 0 -> rank 7)
-
-const int pawnTable[64] = {
-     0,  0,  0,  0,  0,  0,  0,  0,
-    50, 50, 50, 50, 50, 50, 50, 50,
-    10, 10, 20, 30, 30, 20, 10, 10,
-     5,  5, 10, 25, 25, 10,  5,  5,
-     0,  0,  0, 20, 20,  0,  0,  0,
-     5, -5,-10,  0,  0,-10, -5,  5,
-     5, 10, 10,-20,-20, 10, 10,  5,
-     0,  0,  0,  0,  0,  0,  0,  0
-};
+// Attack terms, kept out of EvalTables.cpp because the tuner only fits the
+// material and square tables
+constexpr int mobilityWeights[7] = {0, 0, 4, 4, 2, 1, 0}; // Per move, by PieceType
+constexpr int threatByPawn = 30; // Piece attacked by an enemy pawn
+constexpr int hangingPiece = 15; // Piece attacked and not defended
 
-const int knightTable[64] = {
-    -50,-40,-30,-30,-30,-30,-40,-50,
-    -40,-20,  0,  0,  0,  0,-20,-40,
-    -30,  0, 10, 15, 15, 10,  0,-30,
-    -30,  5, 15, 20, 20, 15,  5,-30,
-    -30,  0, 15, 20, 20, 15,  0,-30,
-    -30,  5, 10, 15, 15, 10,  5,-30,
-    -40,-20,  0,  5,  5,  0,-20,-40,
-    -50,-40,-30,-30,-30,-30,-40,-50
-};
+// Penalty by attacks on the king and the squares next to it
+constexpr int kingDanger[16] = {0, 0, 2, 6, 12, 20, 30, 42, 56, 72, 90, 110, 132, 156, 182, 210};
 
-const int bishopTable[64] = {
-    -20,-10,-10,-10,-10,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5, 10, 10,  5,  0,-10,
-    -10,  5,  5, 10, 10,  5,  5,-10,
-    -10,  0, 10, 10, 10, 10,  0,-10,
-    -10, 10, 10, 10, 10, 10, 10,-10,
-    -10,  5,  0,  0,  0,  0,  5,-10,
-    -20,-10,-10,-10,-10,-10,-10,-20
-};
+// Heuristic, not a bound: kingDanger alone reaches 210 and mobility and
+// threats can add more, so a lazy cut can change a result. Attack terms
+// rarely swing this far against the material and table score.
+constexpr int lazyMargin = 300;
 
-const int rookTable[64] = {
-     0,  0,  0,  0,  0,  0,  0,  0,
-     5, 10, 10, 10, 10, 10, 10,  5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-     0,  0,  0,  5,  5,  0,  0,  0
-};
+} // namespace
 
-const int queenTable[64] = {
-    -20,-10,-10, -5, -5,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5,  5,  5,  5,  0,-10,
-     -5,  0,  5,  5,  5,  5,  0, -5,
-      0,  0,  5,  5,  5,  5,  0, -5,
-    -10,  5,  5,  5,  5,  5,  0,-10,
-    -10,  0,  5,  0,  0,  0,  0,-10,
-    -20,-10,-10, -5, -5,-10,-10,-20
-};
+int Board::evaluate(int alpha, int beta) const {
+    int score = evaluateMaterial();
+    if (score + lazyMargin <= alpha || score - lazyMargin >= beta) return score;
 
-const int kingTable[64] = {
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -20,-30,-30,-40,-40,-30,-30,-20,
-    -10,-20,-20,-20,-20,-20,-20,-10,
-     20, 20,  0,  0,  0,  0, 20, 20,
-     20, 30, 10,  0,  0, 10, 30, 20
-};
+    // Shared with move generation when the node also generates moves
+    const AttackMap& map = getAttacks();
+    int sideScores[2] = {0, 0};
+    for (int side = 0; side < 2; ++side) {
+        int enemy = 1 - side;
+        for (int type = KNIGHT; type <= QUEEN; ++type) sideScores[side] += mobilityWeights[type] * map.mobility[side][type];
+        sideScores[side] -= kingDanger[std::min(map.kingZoneAttacks[side], 15)];
 
-// Helper to get PST value
-int getPstValue(int pieceType, int square, int color) {
-    int rank = square / 8;
-    int file = square % 8;
-    
-    if (color == BLACK) {
-        rank = 7 - rank; // Mirror rank
-        // File mirroring is not strictly necessary for symmetric tables, but good practice
-        // Our tables are symmetric horizontally, so file mirroring doesn't change value
-    }
-    
-    int index = rank * 8 + file;
-    
-    switch (pieceType) {
-        case PAWN: return pawnTable[index];
-        case KNIGHT: return knightTable[index];
-        case BISHOP: return bishopTable[index];
-        case ROOK: return rookTable[index];
-        case QUEEN: return queenTable[index];
-        case KING: return kingTable[index];
-        default: return 0;
+        uint64_t threatened = map.pieces[side] & map.pawnAttacks[enemy];
+        uint64_t hanging = map.pieces[side] & map.attacked[enemy] & ~map.attacked[side] & ~threatened;
+        sideScores[side] -= threatByPawn * countBits(threatened) + hangingPiece * countBits(hanging);
     }
+    return score + sideScores[0] - sideScores[1];
 }
 
-int Board::evaluate() const {
+int Board::computeMaterial() const {
+    const MaterialWeights& weights = materialWeights();
     int score = 0;
-    
-    // Material values (Centipawns)
-    const int pawnValue = 100;
-    const int knightValue = 320;
-    const int bishopValue = 330;
-    const int rookValue = 500;
-    const int queenValue = 900;
-    const int kingValue = 20000;
-    
+    for (int i = 0; i < 64; ++i) score += weights.value[squares[i]][i];
+    return score;
+}
+
+uint64_t Board::computeOccupancy() const {
+    uint64_t bits = 0;
     for (int i = 0; i < 64; ++i) {
-        int piece = squares[i];
-        if (piece == EMPTY) continue;
-        
-        int type = piece & 0x7;
-        int color = piece & 0x18;
-        
-        int value = 0;
-        switch (type) {
-            case PAWN: value = pawnValue; break;
-            case KNIGHT: value = knightValue; break;
-            case BISHOP: value = bishopValue; break;
-            case ROOK: value = rookValue; break;
-            case QUEEN: value = queenValue; break;
-            case KING: value = kingValue; break;
-        }
-        
-        // Add PST value
-        value += getPstValue(type, i, color);
-        
-        if (color == WHITE) {
-            score += value;
-        } else {
-            score -= value;
-        }
+        if (squares[i] != EMPTY) bits |= 1ULL << i;
     }
-    
-    return score;
+    return bits;
 }
@@ -0,0 +1,389 @@
+#include "Daemon.h"
+#include "LineStream.h"
+#include "UCI.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OCTANT_HAVE_UNIX_SOCKETS 1
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+constexpr size_t MAX_LINE_LENGTH = 64 * 1024;
+constexpr size_t MAX_SESSIONS_PER_CONNECTION = 1024;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onStopSignal(int) {
+    stopRequested = 1;
+}
+
+} // namespace
+
+struct Daemon::Connection {
+    int fd;
+    std::mutex writeMutex;
+    std::string readBuffer;
+
+    // Only touched by the I/O thread
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() {
+#ifdef OCTANT_HAVE_UNIX_SOCKETS
+        ::close(fd);
+#endif
+    }
+
+    // Whole lines are written under the lock so sessions never interleave.
+    // Errors are ignored: the I/O thread notices a dead peer on its next read.
+    void send(const std::string& text) {
+#ifdef OCTANT_HAVE_UNIX_SOCKETS
+        std::lock_guard<std::mutex> lock(writeMutex);
+        size_t sent = 0;
+        while (sent < text.size()) {
+            ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            sent += (size_t)n;
+        }
+#endif
+    }
+};
+
+struct Daemon::Session {
+    std::string id;
+    std::shared_ptr<Connection> connection;
+    LineStreamBuf buffer;
+    std::ostream out;
+    UCI uci;
+
+    // Guarded by Daemon::queueMutex
+    std::deque<std::string> pending;
+    bool scheduled = false;
+    bool searching = false; // Running a "go"
+    std::chrono::steady_clock::time_point lastActive;
+
+    Session(std::string sessionId, std::shared_ptr<Connection> conn)
+        : id(std::move(sessionId)),
+          connection(std::move(conn)),
+          buffer([this](std::string_view line) {
+              std::string text;
+              text.reserve(id.size() + line.size() + 2);
+              text.append(id).append(1, ' ').append(line).append(1, '\n');
+              connection->send(text);
+          }),
+          out(&buffer),
+          uci(out),
+          lastActive(std::chrono::steady_clock::now()) {}
+};
+
+Daemon::Daemon(const DaemonOptions& options)
+    : options(options),
+      table(std::make_shared<TranspositionTable>(options.hashMB)),
+      pendingCommands(0),
+      stopping(false) {}
+
+Daemon::~Daemon() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void Daemon::workerLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueReady.wait(lock, [this] { return stopping || !readyQueue.empty(); });
+        if (stopping) return;
+
+        std::shared_ptr<Session> session = std::move(readyQueue.front());
+        readyQueue.pop_front();
+        if (session->pending.empty()) {
+            session->scheduled = false; // Its connection went away
+            continue;
+        }
+        std::string command = std::move(session->pending.front());
+        session->pending.pop_front();
+        --pendingCommands;
+        session->searching = command.compare(0, 2, "go") == 0;
+        lock.unlock();
+
+        // "quit" ends the session's UCI loop; the session itself stays until "close"
+        session->uci.handleCommand(command);
+
+        lock.lock();
+        if (session->searching) {
+            // A stop that arrived as the search finished must not hit the next one
+            session->searching = false;
+            session->uci.clearStop();
+        }
+        session->lastActive = std::chrono::steady_clock::now();
+        // One command per turn so a session with a long queue can't starve the others
+        if (session->pending.empty()) {
+            session->scheduled = false;
+        } else {
+            readyQueue.push_back(std::move(session));
+            queueReady.notify_one();
+        }
+    }
+}
+
+void Daemon::dispatch(const std::shared_ptr<Connection>& connection, const std::string& line) {
+    size_t idEnd = line.find(' ');
+    if (idEnd == 0 || line.empty()) return;
+    std::string id = line.substr(0, idEnd);
+    size_t commandStart = idEnd == std::string::npos ? std::string::npos : line.find_first_not_of(' ', idEnd);
+    std::string command = commandStart == std::string::npos ? "" : line.substr(commandStart);
+    while (!command.empty() && (command.back() == '\r' || command.back() == ' ')) command.pop_back();
+    if (command.empty()) return;
+
+    auto it = connection->sessions.find(id);
+    if (command == "close") {
+        if (it != connection->sessions.end()) {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            pendingCommands -= it->second->pending.size();
+            it->second->pending.clear();
+            if (it->second->searching) it->second->uci.stop();
+            connection->sessions.erase(it);
+        }
+        connection->send(id + " closed\n");
+        return;
+    }
+
+    // "stop" skips the queue: it interrupts the running search and cancels
+    // searches that have not started, which still answer with a null bestmove
+    if (command == "stop") {
+        if (it == connection->sessions.end()) return;
+        Session& session = *it->second;
+        size_t cancelled = 0;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (auto pending = session.pending.begin(); pending != session.pending.end();) {
+                if (pending->compare(0, 2, "go") == 0) {
+                    pending = session.pending.erase(pending);
+                    --pendingCommands;
+                    ++cancelled;
+                } else {
+                    ++pending;
+                }
+            }
+            if (session.searching) session.uci.stop();
+        }
+        for (size_t i = 0; i < cancelled; ++i) connection->send(id + " bestmove 0000\n");
+        return;
+    }
+
+    if (it == connection->sessions.end()) {
+        if (connection->sessions.size() >= MAX_SESSIONS_PER_CONNECTION) {
+            connection->send(id + " error too many sessions\n");
+            return;
+        }
+        auto session = std::make_shared<Session>(id, connection);
+        session->uci.shareTranspositionTable(table);
+        if (cache) session->uci.shareAnalysisCache(cache);
+        it = connection->sessions.emplace(id, std::move(session)).first;
+    }
+    Session& session = *it->second;
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (pendingCommands >= options.queueLimit) {
+        lock.unlock();
+        connection->send(id + " error busy\n");
+        return;
+    }
+    session.pending.push_back(std::move(command));
+    session.lastActive = std::chrono::steady_clock::now();
+    ++pendingCommands;
+    if (!session.scheduled) {
+        session.scheduled = true;
+        readyQueue.push_back(it->second);
+        queueReady.notify_one();
+    }
+}
+
+void Daemon::dropPending(Connection& connection) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto& entry : connection.sessions) {
+        pendingCommands -= entry.second->pending.size();
+        entry.second->pending.clear();
+        if (entry.second->searching) entry.second->uci.stop();
+    }
+}
+
+void Daemon::evictIdleSessions(Connection& connection) {
+    auto now = std::chrono::steady_clock::now();
+    auto timeout = std::chrono::seconds(options.sessionTimeout);
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto it = connection.sessions.begin(); it != connection.sessions.end();) {
+        const Session& session = *it->second;
+        if (!session.scheduled && session.pending.empty() && now - session.lastActive > timeout) {
+            it = connection.sessions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+#ifdef OCTANT_HAVE_UNIX_SOCKETS
+
+int Daemon::run() {
+    sockaddr_un address{};
+    if (options.socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << options.socketPath << std::endl;
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Cannot create socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // A socket file nobody is listening on is left over from a previous run
+    if (::connect(listener, (sockaddr*)&address, sizeof(address)) == 0) {
+        std::cerr << "Another daemon is listening on " << options.socketPath << std::endl;
+        ::close(listener);
+        return 1;
+    }
+    ::close(listener);
+    ::unlink(options.socketPath.c_str());
+
+    listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || ::bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listener, 64) != 0) {
+        std::cerr << "Cannot listen on " << options.socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listener >= 0) ::close(listener);
+        return 1;
+    }
+    ::chmod(options.socketPath.c_str(), 0600);
+
+    if (!options.cacheFile.empty()) {
+        cache = std::make_shared<AnalysisCache>();
+        if (!cache->open(options.cacheFile, options.cacheMB)) {
+            std::cerr << "Cannot open analysis cache " << options.cacheFile << std::endl;
+            ::close(listener);
+            ::unlink(options.socketPath.c_str());
+            return 1;
+        }
+    }
+
+    int workerCount = options.workers > 0 ? options.workers : (int)std::thread::hardware_concurrency();
+    if (workerCount < 1) workerCount = 1;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&Daemon::workerLoop, this);
+    }
+
+    stopRequested = 0;
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "Octant daemon listening on " << options.socketPath << " (workers " << workerCount
+              << ", hash " << options.hashMB << " MB, queue " << options.queueLimit << ")" << std::endl;
+    if (cache) std::cout << "Analysis cache " << cache->getFilename() << " (" << cache->getSizeMB() << " MB)" << std::endl;
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> fds;
+    auto lastEviction = std::chrono::steady_clock::now();
+    char chunk[4096];
+
+    while (!stopRequested) {
+        fds.clear();
+        fds.push_back({listener, POLLIN, 0});
+        for (const auto& connection : connections) fds.push_back({connection->fd, POLLIN, 0});
+
+        int ready = ::poll(fds.data(), fds.size(), 250);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0) connections.push_back(std::make_shared<Connection>(fd));
+        }
+
+        // fds[i + 1] belongs to connections[i]; new connections are polled next round
+        size_t polled = fds.size() - 1;
+        std::vector<bool> closed(polled, false);
+        for (size_t i = 0; i < polled; ++i) {
+            if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            auto& connection = connections[i];
+
+            ssize_t n = ::read(connection->fd, chunk, sizeof(chunk));
+            if (n <= 0) {
+                closed[i] = true;
+                continue;
+            }
+            connection->readBuffer.append(chunk, (size_t)n);
+
+            size_t start = 0;
+            size_t eol;
+            while ((eol = connection->readBuffer.find('\n', start)) != std::string::npos) {
+                dispatch(connection, connection->readBuffer.substr(start, eol - start));
+                start = eol + 1;
+            }
+            connection->readBuffer.erase(0, start);
+            if (connection->readBuffer.size() > MAX_LINE_LENGTH) closed[i] = true;
+        }
+
+        for (size_t i = polled; i-- > 0;) {
+            if (!closed[i]) continue;
+            // Sessions still running finish their current command and are freed after
+            dropPending(*connections[i]);
+            connections[i]->sessions.clear();
+            connections.erase(connections.begin() + i);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastEviction > std::chrono::seconds(5)) {
+            for (auto& connection : connections) evictIdleSessions(*connection);
+            lastEviction = now;
+        }
+    }
+
+    std::cout << "Octant daemon stopping" << std::endl;
+    for (auto& connection : connections) dropPending(*connection);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+
+    // Sessions hold their connection, so break the cycle before letting go
+    for (auto& connection : connections) connection->sessions.clear();
+    connections.clear();
+    ::close(listener);
+    ::unlink(options.socketPath.c_str());
+    return 0;
+}
+
+#else
+
+int Daemon::run() {
+    std::cerr << "Daemon mode needs Unix domain sockets, which this platform does not provide" << std::endl;
+    return 1;
+}
+
+#endif
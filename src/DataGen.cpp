@@ -0,0 +1,254 @@
+#include "DataGen.h"
+#include "MappedFile.h"
+#include "Match.h"
+#include "Search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Scores this large are mates or close to it, and useless as training targets
+constexpr int MAX_TRAINING_SCORE = 10000;
+
+uint64_t nextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Plays 'plies' random legal moves from the start position. Returns false if
+// the game ended on the way.
+bool randomOpening(Board& board, int plies, uint64_t& random) {
+    board.setupStandardPosition();
+    for (int ply = 0; ply < plies; ++ply) {
+        std::vector<Move> moves = board.generateLegalMoves();
+        if (moves.empty()) return false;
+        board.makeMove(moves[nextRandom(random) % moves.size()]);
+    }
+    return !board.generateLegalMoves().empty();
+}
+
+// Plays one game and appends its quiet positions to 'positions', all with
+// the final result. Positions are packed as they are played and get the
+// result once the game is over.
+void playGame(const DataGenOptions& options, Search& search, uint64_t& random,
+              std::vector<PackedPosition>& positions) {
+    Board board;
+    board.setVerbose(false);
+    while (!randomOpening(board, options.randomPlies, random)) {}
+
+    SearchLimits limits;
+    limits.depth = options.depth > 0 ? options.depth : SearchLimits::MAX_DEPTH;
+    limits.nodes = options.nodes;
+
+    size_t first = positions.size();
+    std::vector<uint64_t> history{board.getHash()};
+    int result = 1;
+    ResignAdjudicator resign(options.resignScore, options.resignMoves);
+    search.getTranspositionTable()->clear();
+
+    for (int ply = options.randomPlies;; ++ply) {
+        int turn = board.getTurn();
+        if (board.generateLegalMoves().empty()) {
+            if (board.isInCheck(turn)) result = turn == WHITE ? 0 : 2;
+            break;
+        }
+        if (board.getHalfMoveClock() >= 100 || board.hasInsufficientMaterial() || ply >= options.maxPlies ||
+            std::count(history.begin(), history.end(), board.getHash()) >= 3) {
+            break;
+        }
+
+        int score = 0;
+        search.setInfoCallback([&](const SearchInfo& info) { score = info.score; });
+        Move move = search.findBestMove(board, limits);
+        if (move.from == -1) break;
+
+        int whiteScore = turn == WHITE ? score : -score;
+        bool quiet = !board.isInCheck(turn) && move.capturedPiece == EMPTY && !move.isPromotion;
+        if (ply >= options.minPly && quiet && std::abs(whiteScore) < MAX_TRAINING_SCORE) {
+            positions.push_back(PackedPosition::pack(board, whiteScore, 1));
+        }
+
+        if (int winner = resign.update(whiteScore)) {
+            result = winner > 0 ? 2 : 0;
+            break;
+        }
+
+        if (!board.makeMove(move)) break;
+        if (board.getHalfMoveClock() == 0) history.clear();
+        history.push_back(board.getHash());
+    }
+
+    for (size_t i = first; i < positions.size(); ++i) positions[i].result = (uint8_t)result;
+}
+
+} // namespace
+
+PackedPosition PackedPosition::pack(const Board& board, int score, int result) {
+    PackedPosition p;
+    std::memset(&p, 0, sizeof(p));
+    int count = 0;
+    for (int square = 0; square < 64; ++square) {
+        int piece = board.getPieceAt(square);
+        if (piece == EMPTY) continue;
+        p.occupancy |= 1ULL << square;
+        int nibble = (piece & 0x7) | ((piece & 0x18) == BLACK ? 8 : 0);
+        p.pieces[count / 2] |= (uint8_t)(nibble << (4 * (count % 2)));
+        ++count;
+    }
+    p.score = (int16_t)std::clamp(score, -32767, 32767);
+    p.result = (uint8_t)result;
+    p.flags = (uint8_t)((board.getTurn() == BLACK ? 1 : 0) | (board.getCastlingRights() << 1));
+    p.enPassant = (uint8_t)(board.getEnPassantSquare() < 0 ? 64 : board.getEnPassantSquare());
+    p.halfMoveClock = (uint8_t)std::min(board.getHalfMoveClock(), 255);
+    p.fullMoveNumber = (uint16_t)std::min(board.getFullMoveNumber(), 65535);
+    return p;
+}
+
+bool PackedPosition::unpack(Board& board) const {
+    static const char letters[] = " pnbrqk";
+    int squares[64] = {};
+    uint64_t bits = occupancy;
+    for (int count = 0; bits != 0 && count < 32; ++count) {
+        int square = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        squares[square] = (pieces[count / 2] >> (4 * (count % 2))) & 0xF;
+    }
+    if (bits != 0) return false;
+
+    // Through FEN, which validates the position
+    char fen[100];
+    int length = 0;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            int nibble = squares[rank * 8 + file];
+            if (nibble == 0) {
+                ++empty;
+                continue;
+            }
+            int type = nibble & 0x7;
+            if (type == EMPTY || type > KING) return false;
+            if (empty > 0) fen[length++] = (char)('0' + empty);
+            empty = 0;
+            char letter = letters[type];
+            fen[length++] = (nibble & 8) ? letter : (char)(letter - 'a' + 'A');
+        }
+        if (empty > 0) fen[length++] = (char)('0' + empty);
+        if (rank > 0) fen[length++] = '/';
+    }
+    fen[length++] = ' ';
+    fen[length++] = (flags & 1) ? 'b' : 'w';
+    fen[length++] = ' ';
+    int rights = flags >> 1;
+    if (rights == 0) fen[length++] = '-';
+    if (rights & 1) fen[length++] = 'K';
+    if (rights & 2) fen[length++] = 'Q';
+    if (rights & 4) fen[length++] = 'k';
+    if (rights & 8) fen[length++] = 'q';
+    fen[length++] = ' ';
+    if (enPassant >= 64) {
+        fen[length++] = '-';
+    } else {
+        fen[length++] = (char)('a' + enPassant % 8);
+        fen[length++] = (char)('1' + enPassant / 8);
+    }
+    length += std::snprintf(fen + length, sizeof(fen) - length, " %d %d", halfMoveClock, fullMoveNumber);
+    return board.setFromFEN(std::string_view(fen, length));
+}
+
+bool DataGen::run(const DataGenOptions& options, const std::string& filename, std::ostream& log) {
+    std::ofstream out(filename, std::ios::binary | std::ios::app);
+    if (!out) {
+        log << "Cannot open " << filename << std::endl;
+        return false;
+    }
+
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    uint64_t seed = options.seed != 0 ? options.seed
+                                      : (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+
+    std::mutex outputMutex;
+    uint64_t written = 0;
+    uint64_t games = 0;
+    std::atomic<bool> done(false);
+    auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+
+    auto worker = [&](int index) {
+        std::ostream silent(nullptr);
+        Search search;
+        search.setOutput(silent);
+        search.setTranspositionTable(std::make_shared<TranspositionTable>(options.hashMB));
+        uint64_t random = (seed + (uint64_t)index * 0x9E3779B97F4A7C15ULL) | 1;
+
+        std::vector<PackedPosition> positions;
+        while (!done.load(std::memory_order_relaxed)) {
+            positions.clear();
+            playGame(options, search, random, positions);
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            if (done.load()) break;
+            size_t count = (size_t)std::min<uint64_t>(positions.size(), options.positions - written);
+            out.write(reinterpret_cast<const char*>(positions.data()), (std::streamsize)(count * sizeof(PackedPosition)));
+            written += count;
+            ++games;
+            if (written >= options.positions || !out) done = true;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::seconds(5) || done) {
+                lastReport = now;
+                double seconds = std::chrono::duration<double>(now - start).count();
+                log << "Positions: " << written << " / " << options.positions << "  games " << games
+                    << "  " << (uint64_t)(written / std::max(seconds, 1e-9)) << " positions/s" << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(worker, t);
+    for (auto& w : workers) w.join();
+
+    out.flush();
+    if (!out) {
+        log << "Cannot write " << filename << std::endl;
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    log << "Wrote " << written << " positions from " << games << " games to " << filename << " in "
+        << std::fixed << std::setprecision(1) << seconds << "s (" << threads << " threads)" << std::endl;
+    return true;
+}
+
+bool DataGen::shuffle(const std::string& filename, uint64_t seed, std::ostream& log) {
+    if (!std::ifstream(filename)) {
+        log << "Cannot open " << filename << std::endl;
+        return false;
+    }
+    MappedFile file;
+    if (!file.openShared(filename, 0) || file.size() % sizeof(PackedPosition) != 0) {
+        log << filename << " is not a file of packed positions" << std::endl;
+        return false;
+    }
+
+    PackedPosition* records = reinterpret_cast<PackedPosition*>(file.writableData());
+    size_t count = file.size() / sizeof(PackedPosition);
+    uint64_t random = (seed != 0 ? seed : (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count()) | 1;
+    // Fisher-Yates
+    for (size_t i = count; i > 1; --i) {
+        size_t j = (size_t)(nextRandom(random) % i);
+        std::swap(records[i - 1], records[j]);
+    }
+    file.flush();
+    log << "Shuffled " << count << " positions" << std::endl;
+    return true;
+}
@@ -0,0 +1,255 @@
+#include "EPDSuite.h"
+#include "PGNLoader.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+bool sameMove(const Move& a, const Move& b) {
+    return a.from == b.from && a.to == b.to && a.promotionPiece == b.promotionPiece;
+}
+
+bool contains(const std::vector<Move>& moves, const Move& move) {
+    return std::any_of(moves.begin(), moves.end(), [&](const Move& m) { return sameMove(m, move); });
+}
+
+// Next space-separated word of 'text' starting at 'pos'
+std::string_view nextWord(std::string_view text, size_t& pos) {
+    while (pos < text.size() && text[pos] == ' ') ++pos;
+    size_t start = pos;
+    while (pos < text.size() && text[pos] != ' ') ++pos;
+    return text.substr(start, pos - start);
+}
+
+void writeString(std::ostream& json, std::string_view text) {
+    json << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') json << '\\' << c;
+        else if ((unsigned char)c < 0x20) json << ' ';
+        else json << c;
+    }
+    json << '"';
+}
+
+void writeSANList(std::ostream& json, const std::vector<Move>& moves, Board& board) {
+    json << "[";
+    for (size_t i = 0; i < moves.size(); ++i) {
+        if (i > 0) json << ", ";
+        writeString(json, PGNLoader::toSAN(moves[i], board));
+    }
+    json << "]";
+}
+
+} // namespace
+
+bool EPDSuite::parse(std::string_view line, EPDPosition& position) {
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n' || line.back() == ' ')) line.remove_suffix(1);
+    size_t pos = 0;
+    while (pos < line.size() && line[pos] == ' ') ++pos;
+    if (pos >= line.size() || line[pos] == '#') return false;
+
+    // Placement, side to move, castling, en passant
+    std::string fen;
+    for (int field = 0; field < 4; ++field) {
+        std::string_view word = nextWord(line, pos);
+        if (word.empty()) return false;
+        if (field > 0) fen += ' ';
+        fen.append(word);
+    }
+    fen += " 0 1";
+
+    Board board;
+    board.setVerbose(false);
+    if (!board.setFromFEN(fen)) return false;
+
+    position = EPDPosition();
+    position.fen = fen;
+
+    // Operations: "<opcode> <operand>...;" with optional quoted operands
+    while (pos < line.size()) {
+        std::string_view opcode = nextWord(line, pos);
+        if (opcode.empty()) break;
+
+        std::vector<std::string> operands;
+        std::string operand;
+        bool quoted = false;
+        for (; pos < line.size(); ++pos) {
+            char c = line[pos];
+            if (c == '"') {
+                quoted = !quoted;
+            } else if (!quoted && (c == ' ' || c == ';')) {
+                if (!operand.empty()) operands.push_back(operand);
+                operand.clear();
+                if (c == ';') {
+                    ++pos;
+                    break;
+                }
+            } else {
+                operand += c;
+            }
+        }
+        if (!operand.empty()) operands.push_back(operand);
+
+        if (opcode == "bm" || opcode == "am") {
+            std::vector<Move>& moves = opcode == "bm" ? position.bestMoves : position.avoidMoves;
+            for (const std::string& san : operands) {
+                Move move = PGNLoader::parseSAN(std::string_view(san), board);
+                if (move.from == -1) return false;
+                moves.push_back(move);
+            }
+        } else if (opcode == "id" && !operands.empty()) {
+            position.id = operands[0];
+        } else if (opcode == "acd" && !operands.empty()) {
+            position.depth = std::atoi(operands[0].c_str());
+        } else if (opcode == "c9" && !operands.empty()) {
+            position.result = operands[0];
+        }
+    }
+    return true;
+}
+
+bool EPDSuite::load(const std::string& file, std::ostream& log) {
+    std::ifstream in(file);
+    if (!in) {
+        log << "Cannot open " << file << std::endl;
+        return false;
+    }
+    filename = file;
+    positions.clear();
+
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        EPDPosition position;
+        if (parse(line, position)) {
+            position.line = number;
+            if (position.id.empty()) position.id = "line " + std::to_string(number);
+            positions.push_back(std::move(position));
+        } else if (!trim(line).empty() && trim(line)[0] != '#') {
+            log << "Skipping invalid EPD at line " << number << ": " << line << std::endl;
+        }
+    }
+    return true;
+}
+
+std::vector<EPDResult> EPDSuite::run(const EPDOptions& options, std::ostream& out) const {
+    std::vector<EPDResult> results(positions.size());
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    threads = std::clamp(threads, 1, std::max(1, (int)positions.size()));
+
+    std::atomic<size_t> next(0);
+    std::mutex outputMutex;
+    auto worker = [&] {
+        std::ostream silent(nullptr);
+        Search search;
+        search.setOutput(silent);
+        search.setTranspositionTable(std::make_shared<TranspositionTable>(options.hashMB));
+
+        for (size_t i = next++; i < positions.size(); i = next++) {
+            const EPDPosition& position = positions[i];
+            Board board;
+            board.setVerbose(false);
+            board.setFromFEN(position.fen);
+
+            SearchLimits limits = options.limits;
+            if (!options.depthGiven && position.depth > 0) limits.depth = position.depth;
+
+            EPDResult& result = results[i];
+            search.setInfoCallback([&](const SearchInfo& info) {
+                result.depth = info.depth;
+                result.score = info.score;
+            });
+            search.getTranspositionTable()->clear();
+            auto start = std::chrono::steady_clock::now();
+            result.move = search.findBestMove(board, limits);
+            result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            result.nodes = search.getNodesVisited();
+            search.setInfoCallback(nullptr);
+
+            bool scored = !position.bestMoves.empty() || !position.avoidMoves.empty();
+            result.solved = scored &&
+                            (position.bestMoves.empty() || contains(position.bestMoves, result.move)) &&
+                            !contains(position.avoidMoves, result.move);
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            out << std::left << std::setw(20) << position.id << std::right << " "
+                << (scored ? (result.solved ? "ok  " : "FAIL") : "-   ") << " "
+                << std::left << std::setw(8) << (result.move.from == -1 ? "none" : PGNLoader::toSAN(result.move, board))
+                << std::right << " depth " << std::setw(2) << result.depth << " nodes " << std::setw(10) << result.nodes
+                << " time " << std::fixed << std::setprecision(0) << std::setw(6) << result.milliseconds << "ms" << std::endl;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(worker);
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int scored = 0;
+    int solved = 0;
+    uint64_t nodes = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        scored += !positions[i].bestMoves.empty() || !positions[i].avoidMoves.empty();
+        solved += results[i].solved;
+        nodes += results[i].nodes;
+    }
+    out << "===========================" << std::endl;
+    out << "Solved: " << solved << " / " << scored << " (" << positions.size() << " positions, "
+        << threads << " threads)" << std::endl;
+    out << "Nodes: " << nodes << std::endl;
+    out << "Time: " << std::fixed << std::setprecision(3) << seconds << "s" << std::endl;
+    out << "NPS: " << (uint64_t)(nodes / std::max(seconds, 1e-9)) << std::endl;
+    return results;
+}
+
+void EPDSuite::writeJSON(const std::vector<EPDResult>& results, const EPDOptions& options,
+                         double seconds, std::ostream& json) const {
+    int solved = 0;
+    uint64_t nodes = 0;
+    for (const EPDResult& r : results) {
+        solved += r.solved;
+        nodes += r.nodes;
+    }
+
+    json << "{\n  \"file\": ";
+    writeString(json, filename);
+    json << ",\n  \"limits\": {\"depth\": " << (options.depthGiven ? options.limits.depth : 0)
+         << ", \"movetime\": " << options.limits.movetime << ", \"nodes\": " << options.limits.nodes << "},\n";
+    json << "  \"positions\": " << results.size() << ",\n  \"solved\": " << solved << ",\n";
+    json << "  \"nodes\": " << nodes << ",\n  \"seconds\": " << std::fixed << std::setprecision(3) << seconds << ",\n";
+    json << "  \"nps\": " << (uint64_t)(nodes / std::max(seconds, 1e-9)) << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const EPDPosition& position = positions[i];
+        const EPDResult& r = results[i];
+        Board board;
+        board.setVerbose(false);
+        board.setFromFEN(position.fen);
+
+        json << "    {\"id\": ";
+        writeString(json, position.id);
+        json << ", \"fen\": ";
+        writeString(json, position.fen);
+        json << ", \"move\": ";
+        writeString(json, r.move.from == -1 ? "" : PGNLoader::toSAN(r.move, board));
+        json << ", \"uci\": ";
+        writeString(json, moveToUci(r.move));
+        json << ", \"bm\": ";
+        writeSANList(json, position.bestMoves, board);
+        json << ", \"am\": ";
+        writeSANList(json, position.avoidMoves, board);
+        json << ", \"solved\": " << (r.solved ? "true" : "false") << ", \"depth\": " << r.depth
+             << ", \"score\": " << r.score << ", \"nodes\": " << r.nodes
+             << ", \"ms\": " << std::setprecision(1) << r.milliseconds << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+        json << std::setprecision(3);
+    }
+    json << "  ]\n}\n";
+}
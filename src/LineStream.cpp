@@ -0,0 +1,29 @@
+#include "LineStream.h"
+
+int LineStreamBuf::overflow(int c) {
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    if (c == '\n') {
+        callback(line);
+        line.clear();
+    } else {
+        line.push_back((char)c);
+    }
+    return c;
+}
+
+std::streamsize LineStreamBuf::xsputn(const char* s, std::streamsize n) {
+    std::string_view text(s, (size_t)n);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) {
+            line.append(text.substr(pos));
+            break;
+        }
+        line.append(text.substr(pos, eol - pos));
+        callback(line);
+        line.clear();
+        pos = eol + 1;
+    }
+    return n;
+}
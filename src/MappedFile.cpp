@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OCTANT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+#ifdef OCTANT_HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    length = (size_t)st.st_size;
+    if (length > 0) {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        madvise(p, length, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(p);
+        mapped = true;
+    }
+    ::close(fd); // The mapping keeps its own reference
+    opened = true;
+    return true;
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    buffer.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+    ptr = buffer.data();
+    length = buffer.size();
+    opened = true;
+    return true;
+#endif
+}
+
+bool MappedFile::openShared(const std::string& filename, size_t size) {
+    close();
+
+#ifdef OCTANT_HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    // Held while sizing, so two processes creating the file at once cannot
+    // shrink it under each other
+    flock(fd, LOCK_EX);
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size == 0) {
+        ok = ftruncate(fd, (off_t)size) == 0;
+        st.st_size = (off_t)size;
+    }
+    flock(fd, LOCK_UN);
+
+    length = ok ? (size_t)st.st_size : 0;
+    if (length == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        length = 0;
+        return false;
+    }
+    ptr = static_cast<const char*>(p);
+    mapped = true;
+    writable = true;
+    opened = true;
+    return true;
+#else
+    (void)filename;
+    (void)size;
+    return false;
+#endif
+}
+
+void MappedFile::flush() {
+#ifdef OCTANT_HAVE_MMAP
+    if (mapped && writable) msync(const_cast<char*>(ptr), length, MS_ASYNC);
+#endif
+}
+
+void MappedFile::close() {
+#ifdef OCTANT_HAVE_MMAP
+    if (mapped) munmap(const_cast<char*>(ptr), length);
+#endif
+    buffer.clear();
+    buffer.shrink_to_fit();
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+    mapped = false;
+    writable = false;
+}
@@ -0,0 +1,367 @@
+#include "Match.h"
+#include "EPDSuite.h"
+#include "PGNLoader.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+double eloToScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double scoreToElo(double score) {
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Variance of one game's points around the mean score
+double scoreVariance(const MatchScore& s) {
+    int n = s.games();
+    if (n == 0) return 0;
+    double mean = s.score();
+    return (s.wins * (1.0 - mean) * (1.0 - mean) + s.draws * (0.5 - mean) * (0.5 - mean) +
+            s.losses * mean * mean) / n;
+}
+
+struct GameResult {
+    int result = 0;              // 1 White won, 0 draw, -1 Black won
+    std::string reason;
+    bool adjudicated = false;
+    bool timeForfeit = false;
+    std::vector<std::string> moves; // SAN
+};
+
+GameResult playGame(const MatchOptions& options, const std::string& fen, int whiteEngine, Search searches[2]) {
+    GameResult game;
+    Board board;
+    board.setVerbose(false);
+    board.setFromFEN(fen);
+
+    std::vector<uint64_t> positions{board.getHash()};
+    int64_t clock[2] = {options.engines[0].timeMs, options.engines[1].timeMs};
+    ResignAdjudicator resign(options.resignScore, options.resignMoves);
+    int drawStreak = 0;
+
+    for (int ply = 0;; ++ply) {
+        int turn = board.getTurn();
+        std::vector<Move> legal = board.generateLegalMoves();
+        if (legal.empty()) {
+            if (board.isInCheck(turn)) {
+                game.result = turn == WHITE ? -1 : 1;
+                game.reason = turn == WHITE ? "Black mates" : "White mates";
+            } else {
+                game.reason = "stalemate";
+            }
+            return game;
+        }
+        if (board.getHalfMoveClock() >= 100) {
+            game.reason = "fifty-move rule";
+            return game;
+        }
+        if (std::count(positions.begin(), positions.end(), board.getHash()) >= 3) {
+            game.reason = "threefold repetition";
+            return game;
+        }
+        if (board.hasInsufficientMaterial()) {
+            game.reason = "insufficient material";
+            return game;
+        }
+        if (ply >= options.maxPlies) {
+            game.reason = "move limit";
+            game.adjudicated = true;
+            return game;
+        }
+
+        int side = turn == WHITE ? whiteEngine : 1 - whiteEngine;
+        const MatchEngine& engine = options.engines[side];
+        SearchLimits limits = engine.limits;
+        if (engine.timeMs > 0) {
+            limits.depth = SearchLimits::MAX_DEPTH;
+            limits.movetime = std::max<int64_t>(1, clock[side] / 20 + engine.incrementMs * 3 / 4);
+        }
+
+        int score = 0;
+        searches[side].setInfoCallback([&](const SearchInfo& info) { score = info.score; });
+        auto start = std::chrono::steady_clock::now();
+        Move move = searches[side].findBestMove(board, limits);
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        if (engine.timeMs > 0) {
+            clock[side] -= elapsed;
+            if (clock[side] < 0) {
+                game.result = turn == WHITE ? -1 : 1;
+                game.reason = turn == WHITE ? "White loses on time" : "Black loses on time";
+                game.timeForfeit = true;
+                return game;
+            }
+            clock[side] += engine.incrementMs;
+        }
+
+        std::string san = move.from == -1 ? "" : PGNLoader::toSAN(move, board);
+        if (move.from == -1 || !board.makeMove(move)) {
+            game.result = turn == WHITE ? -1 : 1;
+            game.reason = turn == WHITE ? "White makes an illegal move" : "Black makes an illegal move";
+            return game;
+        }
+        game.moves.push_back(san);
+        if (board.getHalfMoveClock() == 0) positions.clear();
+        positions.push_back(board.getHash());
+
+        // Adjudication on the engines' own scores, converted to White's view
+        int whiteScore = turn == WHITE ? score : -score;
+        if (int winner = resign.update(whiteScore)) {
+            game.result = winner;
+            game.reason = winner > 0 ? "Black resigns" : "White resigns";
+            game.adjudicated = true;
+            return game;
+        }
+        drawStreak = (ply + 1 >= options.drawMinPly && std::abs(whiteScore) <= options.drawScore) ? drawStreak + 1 : 0;
+        if (drawStreak >= 2 * options.drawMoves) {
+            game.reason = "draw by adjudication";
+            game.adjudicated = true;
+            return game;
+        }
+    }
+}
+
+void writePGN(std::ostream& pgn, const MatchOptions& options, const std::string& fen, int round,
+              int whiteEngine, const GameResult& game) {
+    const char* result = game.result > 0 ? "1-0" : game.result < 0 ? "0-1" : "1/2-1/2";
+    std::time_t now = std::time(nullptr);
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+    pgn << "[Event \"Octant match\"]\n[Site \"?\"]\n[Date \"" << date << "\"]\n[Round \"" << round << "\"]\n"
+        << "[White \"" << options.engines[whiteEngine].name << "\"]\n"
+        << "[Black \"" << options.engines[1 - whiteEngine].name << "\"]\n"
+        << "[Result \"" << result << "\"]\n";
+    if (fen != START_FEN) pgn << "[SetUp \"1\"]\n[FEN \"" << fen << "\"]\n";
+    pgn << "[PlyCount \"" << game.moves.size() << "\"]\n"
+        << "[Termination \"" << (game.timeForfeit ? "time forfeit" : game.adjudicated ? "adjudication" : "normal")
+        << "\"]\n\n";
+
+    Board board;
+    board.setVerbose(false);
+    board.setFromFEN(fen);
+    int moveNumber = board.getFullMoveNumber();
+    bool white = board.getTurn() == WHITE;
+
+    std::string line;
+    auto emit = [&](const std::string& word) {
+        if (!line.empty() && line.size() + 1 + word.size() > 79) {
+            pgn << line << "\n";
+            line.clear();
+        }
+        if (!line.empty()) line += ' ';
+        line += word;
+    };
+    for (size_t i = 0; i < game.moves.size(); ++i) {
+        if (white) emit(std::to_string(moveNumber) + ".");
+        else if (i == 0) emit(std::to_string(moveNumber) + "...");
+        emit(game.moves[i]);
+        if (!white) ++moveNumber;
+        white = !white;
+    }
+    emit("{" + game.reason + "}");
+    emit(result);
+    pgn << line << "\n\n";
+}
+
+} // namespace
+
+bool MatchEngine::configure(std::string_view spec) {
+    bool depthSet = false;
+    bool limitSet = false;
+    for (const std::string& setting : split(std::string(spec), ',')) {
+        if (trim(setting).empty()) continue;
+        size_t eq = setting.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = trim(setting.substr(0, eq));
+        std::string value = trim(setting.substr(eq + 1));
+        try {
+            if (key == "name") name = value;
+            else if (key == "depth") {
+                limits.depth = std::clamp(std::stoi(value), 1, SearchLimits::MAX_DEPTH);
+                depthSet = true;
+            } else if (key == "nodes") {
+                limits.nodes = std::stoull(value);
+                limitSet = true;
+            } else if (key == "movetime") {
+                limits.movetime = std::stoll(value);
+                limitSet = true;
+            }
+            else if (key == "hash") hashMB = (size_t)std::stoul(value);
+            else if (key == "tc") {
+                size_t plus = value.find('+');
+                timeMs = (int64_t)(std::stod(value.substr(0, plus)) * 1000);
+                incrementMs = plus == std::string::npos ? 0 : (int64_t)(std::stod(value.substr(plus + 1)) * 1000);
+            } else return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    // A node or time limit alone is not cut short by the default depth
+    if (limitSet && !depthSet) limits.depth = SearchLimits::MAX_DEPTH;
+    return true;
+}
+
+int ResignAdjudicator::update(int whiteScore) {
+    if (std::abs(whiteScore) >= score) {
+        int sign = whiteScore > 0 ? 1 : -1;
+        streak = (streak * sign > 0) ? streak + sign : sign;
+    } else {
+        streak = 0;
+    }
+    if (std::abs(streak) < 2 * moves) return 0;
+    return streak > 0 ? 1 : -1;
+}
+
+double MatchScore::score() const {
+    return games() == 0 ? 0.5 : (wins + 0.5 * draws) / games();
+}
+
+double MatchScore::elo() const {
+    return scoreToElo(score());
+}
+
+double MatchScore::eloError() const {
+    if (games() == 0) return 0;
+    double error = 1.96 * std::sqrt(scoreVariance(*this) / games());
+    return (scoreToElo(score() + error) - scoreToElo(score() - error)) / 2;
+}
+
+double MatchScore::llr(double elo0, double elo1) const {
+    double variance = scoreVariance(*this);
+    if (games() == 0 || variance <= 0) return 0;
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return games() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * variance);
+}
+
+bool Match::loadOpenings(const std::string& filename, std::vector<std::string>& openings, std::ostream& log) {
+    std::ifstream in(filename);
+    if (!in) {
+        log << "Cannot open " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        EPDPosition position;
+        if (EPDSuite::parse(line, position)) {
+            openings.push_back(position.fen);
+        } else if (!trim(line).empty() && trim(line)[0] != '#') {
+            log << "Skipping invalid opening at line " << number << ": " << line << std::endl;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> Match::defaultOpenings() {
+    std::vector<std::string> openings;
+    Board board;
+    board.setVerbose(false);
+    board.setupStandardPosition();
+    for (const Move& first : board.generateLegalMoves()) {
+        board.makeMove(first);
+        for (const Move& reply : board.generateLegalMoves()) {
+            board.makeMove(reply);
+            openings.push_back(board.toFEN());
+            board.unmakeMove(reply);
+        }
+        board.unmakeMove(first);
+    }
+    return openings;
+}
+
+MatchScore Match::run(const MatchOptions& options, std::ostream& out) {
+    MatchScore total;
+    if (options.openings.empty()) return total;
+    int games = options.games > 0 ? options.games : 2 * (int)options.openings.size();
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    threads = std::clamp(threads, 1, games);
+
+    std::ofstream pgn;
+    if (!options.pgnFile.empty()) {
+        pgn.open(options.pgnFile, std::ios::app);
+        if (!pgn) out << "Cannot open " << options.pgnFile << ", no PGN written" << std::endl;
+    }
+
+    const std::string& nameA = options.engines[0].name;
+    const std::string& nameB = options.engines[1].name;
+    double lower = std::log(options.beta / (1 - options.alpha));
+    double upper = std::log((1 - options.beta) / options.alpha);
+
+    out << nameA << " vs " << nameB << ": " << games << " games from " << options.openings.size()
+        << " openings on " << threads << " threads" << std::endl;
+
+    std::atomic<int> next(0);
+    std::atomic<bool> finished(false);
+    std::mutex resultMutex;
+    int played = 0;
+    auto worker = [&] {
+        std::ostream silent(nullptr);
+        Search searches[2];
+        for (int e = 0; e < 2; ++e) {
+            searches[e].setOutput(silent);
+            searches[e].setTranspositionTable(std::make_shared<TranspositionTable>(options.engines[e].hashMB));
+        }
+
+        for (int g = next++; g < games && !finished.load(); g = next++) {
+            // Each opening is played twice in a row with colors reversed
+            const std::string& fen = options.openings[(size_t)(g / 2) % options.openings.size()];
+            int whiteEngine = g % 2;
+            for (Search& search : searches) search.getTranspositionTable()->clear();
+            GameResult game = playGame(options, fen, whiteEngine, searches);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (finished.load()) break; // SPRT already decided; games still running do not count
+            int forA = whiteEngine == 0 ? game.result : -game.result;
+            if (forA > 0) ++total.wins;
+            else if (forA < 0) ++total.losses;
+            else ++total.draws;
+            ++played;
+            if (pgn) writePGN(pgn, options, fen, g + 1, whiteEngine, game);
+
+            double llr = total.llr(options.elo0, options.elo1);
+            out << "Game " << std::setw(4) << played << ": " << options.engines[whiteEngine].name << " - "
+                << options.engines[1 - whiteEngine].name << " "
+                << (game.result > 0 ? "1-0" : game.result < 0 ? "0-1" : "1/2-1/2") << " {" << game.reason << "}"
+                << "  " << total.wins << "-" << total.losses << "-" << total.draws
+                << std::fixed << std::setprecision(1) << "  Elo " << total.elo() << " +/- " << total.eloError()
+                << std::setprecision(2) << "  LLR " << llr << std::endl;
+            if (options.sprt && (llr <= lower || llr >= upper)) finished = true;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(worker);
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double llr = total.llr(options.elo0, options.elo1);
+    out << "===========================" << std::endl;
+    out << "Score of " << nameA << " vs " << nameB << ": " << total.wins << " - " << total.losses << " - "
+        << total.draws << std::fixed << std::setprecision(3) << " [" << total.score() << "] " << total.games()
+        << " games" << std::endl;
+    out << std::setprecision(1) << "Elo difference: " << total.elo() << " +/- " << total.eloError() << std::endl;
+    out << std::setprecision(2) << "SPRT (" << options.elo0 << ", " << options.elo1 << "): LLR " << llr
+        << " (" << lower << ", " << upper << ") "
+        << (llr >= upper ? "H1 accepted" : llr <= lower ? "H0 accepted" : "inconclusive") << std::endl;
+    out << std::setprecision(3) << "Time: " << seconds << "s" << std::endl;
+    return total;
+}
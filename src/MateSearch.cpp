@@ -0,0 +1,234 @@
+#include "MateSearch.h"
+#include "Utils.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t INFINITE_PN = 1u << 30;
+
+// Initial proof number of an attacker move: checks are expanded first
+constexpr uint32_t CHECK_PN = 1;
+constexpr uint32_t QUIET_PN = 3;
+
+// Proofs at different remaining depths are different results
+inline uint64_t depthKey(uint64_t hash, int remaining) {
+    return hash ^ ((uint64_t)(remaining + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+inline uint32_t addCapped(uint64_t a, uint64_t b) {
+    return (uint32_t)std::min<uint64_t>(a + b, INFINITE_PN);
+}
+
+} // namespace
+
+MateSearch::MateSearch(size_t megabytes) : sizeMB(std::max<size_t>(megabytes, 1)), out(&std::cout) {}
+
+bool MateSearch::lookup(uint64_t key, uint32_t& pn, uint32_t& dn) const {
+    const Bucket& bucket = table[key & (table.size() - 1)];
+    for (const Entry& entry : bucket.entries) {
+        if (entry.key == key) {
+            pn = entry.pn;
+            dn = entry.dn;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MateSearch::store(uint64_t key, uint32_t pn, uint32_t dn) {
+    Bucket& bucket = table[key & (table.size() - 1)];
+    Entry* victim = nullptr;
+    for (Entry& entry : bucket.entries) {
+        if (entry.key == key) {
+            victim = &entry;
+            break;
+        }
+        bool solved = entry.pn == 0 || entry.dn == 0;
+        // Empty slots first, then the least promising open node
+        if (entry.key == 0) {
+            if (!victim || victim->key != 0) victim = &entry;
+        } else if (!solved && (!victim || (victim->key != 0 && entry.pn + entry.dn < victim->pn + victim->dn))) {
+            victim = &entry;
+        }
+    }
+    if (!victim) victim = &bucket.entries[(key >> 32) & 3];
+    *victim = {key, pn, dn};
+}
+
+bool MateSearch::limitReached() const {
+    if (stopRequested.load(std::memory_order_relaxed)) return true;
+    if (limits.nodes > 0 && nodes >= limits.nodes) return true;
+    if (limits.movetime > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        if (elapsed.count() >= limits.movetime) return true;
+    }
+    return false;
+}
+
+// Legal moves of the node with the keys of the positions they lead to. On
+// the attacker's last move only checks can mate.
+void MateSearch::children(Board& board, int remaining, bool attacker, std::vector<Child>& list) {
+    list.clear();
+    for (const Move& move : board.generateLegalMoves()) {
+        board.makeMove(move);
+        Child child{move, depthKey(board.getHash(), remaining - 1), board.getHash(), board.isInCheck(board.getTurn())};
+        board.unmakeMove(move);
+        if (attacker && remaining == 1 && !child.check) continue;
+        list.push_back(child);
+    }
+}
+
+void MateSearch::mid(Board& board, uint64_t key, int remaining, bool attacker, uint32_t thresholdPn, uint32_t thresholdDn) {
+    if ((++nodes & 1023) == 0 && limitReached()) aborted = true;
+    if (aborted) return;
+
+    // A defender without depth left escapes unless already mated
+    if (!attacker && remaining == 0) {
+        bool mated = board.isInCheck(board.getTurn()) && board.generateLegalMoves().empty();
+        store(key, mated ? 0 : INFINITE_PN, mated ? INFINITE_PN : 0);
+        return;
+    }
+
+    std::vector<Child> list;
+    children(board, remaining, attacker, list);
+    if (list.empty()) {
+        // Checkmate proves a defender node; everything else is no mate
+        bool mated = !attacker && board.isInCheck(board.getTurn());
+        store(key, mated ? 0 : INFINITE_PN, mated ? INFINITE_PN : 0);
+        return;
+    }
+
+    std::vector<uint32_t> pns(list.size());
+    std::vector<uint32_t> dns(list.size());
+    for (;;) {
+        uint64_t sumPn = 0;
+        uint64_t sumDn = 0;
+        uint32_t minPn = INFINITE_PN;
+        uint32_t minDn = INFINITE_PN;
+        size_t best = 0;
+        uint32_t second = INFINITE_PN;
+        for (size_t i = 0; i < list.size(); ++i) {
+            uint32_t pn;
+            uint32_t dn;
+            if (!lookup(list[i].key, pn, dn)) {
+                pn = attacker && !list[i].check ? QUIET_PN : CHECK_PN;
+                dn = 1;
+            }
+            pns[i] = pn;
+            dns[i] = dn;
+            sumPn += pn;
+            sumDn += dn;
+            // Attacker: the child easiest to prove; defender: easiest to refute
+            uint32_t rank = attacker ? pn : dn;
+            uint32_t bestRank = attacker ? minPn : minDn;
+            if (rank < bestRank) {
+                second = bestRank;
+                best = i;
+            } else if (rank < second) {
+                second = rank;
+            }
+            minPn = std::min(minPn, pn);
+            minDn = std::min(minDn, dn);
+        }
+
+        uint32_t pn = attacker ? minPn : (uint32_t)std::min<uint64_t>(sumPn, INFINITE_PN);
+        uint32_t dn = attacker ? (uint32_t)std::min<uint64_t>(sumDn, INFINITE_PN) : minDn;
+        if (pn >= thresholdPn || dn >= thresholdDn || aborted) {
+            store(key, pn, dn);
+            return;
+        }
+
+        uint32_t childPn;
+        uint32_t childDn;
+        if (attacker) {
+            childPn = std::min<uint32_t>(thresholdPn, addCapped(second, 1));
+            childDn = addCapped(thresholdDn - dn, dns[best]);
+        } else {
+            childPn = addCapped(thresholdPn - pn, pns[best]);
+            childDn = std::min<uint32_t>(thresholdDn, addCapped(second, 1));
+        }
+
+        board.makeMove(list[best].move);
+        mid(board, list[best].key, remaining - 1, !attacker, childPn, childDn);
+        board.unmakeMove(list[best].move);
+    }
+}
+
+// Follows proofs in the table: the attacker's fastest mate against the
+// defender's longest resistance
+void MateSearch::principalVariation(Board& board, int remaining, std::vector<Move>& pv) {
+    bool attacker = true;
+    std::vector<Child> list;
+    for (; remaining > 0; --remaining, attacker = !attacker) {
+        children(board, remaining, attacker, list);
+        const Child* chosen = nullptr;
+        int chosenDepth = 0;
+        for (const Child& child : list) {
+            // Shallowest remaining depth at which the child is proven
+            int depth = -1;
+            for (int d = (remaining - 1) % 2; d <= remaining - 1 && depth < 0; d += 2) {
+                uint32_t pn;
+                uint32_t dn;
+                if (lookup(depthKey(child.hash, d), pn, dn) && pn == 0) depth = d;
+            }
+            if (depth < 0) continue;
+            if (!chosen || (attacker ? depth < chosenDepth : depth > chosenDepth)) {
+                chosen = &child;
+                chosenDepth = depth;
+            }
+        }
+        if (!chosen) break;
+        pv.push_back(chosen->move);
+        board.makeMove(chosen->move);
+    }
+    for (auto it = pv.rbegin(); it != pv.rend(); ++it) board.unmakeMove(*it);
+}
+
+bool MateSearch::solve(Board& board, int maxMoves, const SearchLimits& searchLimits, MateResult& result) {
+    result = MateResult();
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    nodes = 0;
+    aborted = false;
+    if (table.empty()) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Bucket) <= sizeMB * 1024 * 1024) count *= 2;
+        table.resize(count);
+    }
+    std::fill(table.begin(), table.end(), Bucket{});
+
+    auto report = [&](int plies) {
+        result.nodes = nodes;
+        result.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+        uint64_t nps = nodes * 1000 / (uint64_t)std::max<int64_t>(result.milliseconds, 1);
+        *out << "info depth " << plies;
+        if (result.moves > 0) *out << " score mate " << result.moves;
+        *out << " nodes " << nodes << " nps " << nps << " time " << result.milliseconds;
+        if (!result.pv.empty()) {
+            *out << " pv";
+            for (const Move& move : result.pv) *out << " " << moveToUci(move);
+        }
+        *out << std::endl;
+    };
+
+    for (int moves = 1; moves <= maxMoves; ++moves) {
+        int plies = 2 * moves - 1;
+        uint64_t key = depthKey(board.getHash(), plies);
+        uint32_t pn = 1;
+        uint32_t dn = 1;
+        while (pn != 0 && dn != 0 && !aborted) {
+            mid(board, key, plies, true, INFINITE_PN, INFINITE_PN);
+            if (!lookup(key, pn, dn)) break;
+        }
+        if (aborted) break;
+        if (pn == 0) {
+            result.moves = moves;
+            principalVariation(board, plies, result.pv);
+            report(plies);
+            return true;
+        }
+        report(plies);
+    }
+    return false;
+}
@@ -0,0 +1,195 @@
+#include "octant.h"
+#include "Benchmark.h"
+#include "Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include "Utils.h"
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct OctantTable {
+    std::shared_ptr<TranspositionTable> table;
+};
+
+struct OctantEngine {
+    Board board;
+    Search search;
+    bool sharedTable = false;
+    std::ostream silent{nullptr}; // Swallows the search's progress output
+
+    // Guards 'searching' so octant_stop only reaches a running search
+    std::mutex stopMutex;
+    bool searching = false;
+};
+
+namespace {
+
+// Applies space-separated UCI moves; returns false at the first illegal one
+bool applyMoves(Board& board, std::string_view moves) {
+    size_t pos = 0;
+    while (pos < moves.size()) {
+        size_t start = moves.find_first_not_of(' ', pos);
+        if (start == std::string_view::npos) break;
+        size_t end = moves.find(' ', start);
+        if (end == std::string_view::npos) end = moves.size();
+        Move move = board.parseUciMove(moves.substr(start, end - start));
+        if (move.from == -1 || !board.makeMove(move)) return false;
+        pos = end;
+    }
+    return true;
+}
+
+} // namespace
+
+extern "C" {
+
+const char* octant_version(void) {
+    return "Octant 0.1";
+}
+
+OctantTable* octant_table_create(size_t megabytes) {
+    try {
+        return new OctantTable{std::make_shared<TranspositionTable>(megabytes)};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void octant_table_release(OctantTable* table) {
+    delete table;
+}
+
+OctantEngine* octant_create(OctantTable* table) {
+    try {
+        auto engine = std::make_unique<OctantEngine>();
+        engine->board.setVerbose(false);
+        engine->board.setupStandardPosition();
+        engine->search.setOutput(engine->silent);
+        if (table) {
+            engine->search.setTranspositionTable(table->table);
+            engine->sharedTable = true;
+        }
+        return engine.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void octant_destroy(OctantEngine* engine) {
+    delete engine;
+}
+
+int octant_set_position(OctantEngine* engine, const char* position, const char* moves) {
+    if (!engine || !position) return OCTANT_ERROR_ARGUMENT;
+    try {
+        Board board;
+        board.setVerbose(false);
+        std::string_view base(position);
+        if (base == "startpos") {
+            board.setupStandardPosition();
+        } else if (!board.setFromFEN(base)) {
+            return OCTANT_ERROR_FEN;
+        }
+        if (moves && !applyMoves(board, moves)) return OCTANT_ERROR_MOVE;
+        engine->board = board;
+        return OCTANT_OK;
+    } catch (...) {
+        return OCTANT_ERROR_INTERNAL;
+    }
+}
+
+int octant_get_fen(OctantEngine* engine, char* buffer, size_t size) {
+    if (!engine || !buffer || size == 0) return OCTANT_ERROR_ARGUMENT;
+    try {
+        std::string fen = engine->board.toFEN();
+        if (fen.size() + 1 > size) return OCTANT_ERROR_ARGUMENT;
+        std::memcpy(buffer, fen.c_str(), fen.size() + 1);
+        return (int)fen.size();
+    } catch (...) {
+        return OCTANT_ERROR_INTERNAL;
+    }
+}
+
+int octant_search(OctantEngine* engine, const OctantLimits* limits,
+                  OctantInfoCallback callback, void* user,
+                  char* bestmove, int* score) {
+    if (!engine || !bestmove) return OCTANT_ERROR_ARGUMENT;
+    try {
+        SearchLimits searchLimits;
+        if (limits) {
+            searchLimits.depth = limits->depth > 0 ? limits->depth : SearchLimits::MAX_DEPTH;
+            searchLimits.movetime = limits->movetime;
+            searchLimits.nodes = limits->nodes;
+        }
+
+        int lastScore = 0;
+        engine->search.setInfoCallback([&](const SearchInfo& info) {
+            lastScore = info.score;
+            if (!callback) return;
+            std::string pv;
+            for (const Move& move : info.pv) {
+                if (!pv.empty()) pv += ' ';
+                pv += moveToUci(move);
+            }
+            OctantInfo out{info.depth, info.score, info.mate, info.nodes, info.nps, info.milliseconds, pv.c_str()};
+            callback(&out, user);
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(engine->stopMutex);
+            engine->searching = true;
+        }
+        Move best = engine->search.findBestMove(engine->board, searchLimits);
+        engine->search.setInfoCallback(nullptr);
+        {
+            // A stop that arrived as the search finished must not hit the next one
+            std::lock_guard<std::mutex> lock(engine->stopMutex);
+            engine->searching = false;
+            engine->search.clearStop();
+        }
+
+        std::string uci = moveToUci(best);
+        std::memcpy(bestmove, uci.c_str(), uci.size() + 1);
+        if (score) *score = lastScore;
+        return OCTANT_OK;
+    } catch (...) {
+        engine->search.setInfoCallback(nullptr);
+        std::lock_guard<std::mutex> lock(engine->stopMutex);
+        engine->searching = false;
+        engine->search.clearStop();
+        return OCTANT_ERROR_INTERNAL;
+    }
+}
+
+void octant_stop(OctantEngine* engine) {
+    if (!engine) return;
+    std::lock_guard<std::mutex> lock(engine->stopMutex);
+    if (engine->searching) engine->search.stop();
+}
+
+void octant_new_game(OctantEngine* engine) {
+    if (!engine) return;
+    engine->board.setupStandardPosition();
+    if (!engine->sharedTable) engine->search.getTranspositionTable()->clear();
+}
+
+uint64_t octant_perft(OctantEngine* engine, int depth) {
+    if (!engine || depth < 0) return 0;
+    try {
+        return Benchmark::perft(engine->board, depth);
+    } catch (...) {
+        return 0;
+    }
+}
+
+int octant_evaluate(OctantEngine* engine) {
+    if (!engine) return 0;
+    return engine->board.evaluate();
+}
+
+} // extern "C"
@@ -0,0 +1,289 @@
+#include "OpeningExplorer.h"
+#include "PGNLoader.h"
+#include "PGNReader.h"
+#include "SearchTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <unordered_map>
+
+struct OpeningExplorer::Record {
+    uint64_t key;
+    uint16_t move; // packTraceMove() encoding
+    uint16_t reserved;
+    uint32_t whiteWins;
+    uint32_t draws;
+    uint32_t blackWins;
+};
+
+namespace {
+
+constexpr uint64_t EXPLORER_MAGIC = 0x314c50584554434fULL; // "OCTEXPL1"
+constexpr uint32_t EXPLORER_VERSION = 1;
+
+// Records follow the header in native byte order
+struct ExplorerHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t startKey;    // Board::getHash() of the start position, identifies the Zobrist keys
+    uint64_t recordCount;
+    uint64_t gameCount;
+};
+
+struct Counts {
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+    uint32_t blackWins = 0;
+};
+
+// Position key and move of one record
+struct PositionMove {
+    uint64_t key;
+    uint16_t move;
+    bool operator==(const PositionMove& other) const { return key == other.key && move == other.move; }
+};
+
+struct PositionMoveHash {
+    size_t operator()(const PositionMove& pm) const {
+        return (size_t)(pm.key ^ ((uint64_t)pm.move * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+using MoveTable = std::unordered_map<PositionMove, Counts, PositionMoveHash>;
+
+uint64_t startKey() {
+    Board board;
+    board.setVerbose(false);
+    board.setupStandardPosition();
+    return board.getHash();
+}
+
+// Replays every 'stride'-th game starting at 'first' of each file into 'table'
+void indexGames(const std::vector<std::string>& pgnFiles, size_t first, size_t stride,
+                const ExplorerBuildOptions& options, MoveTable& table, uint64_t& games, uint64_t& skipped) {
+    PGNReader reader;
+    PGNGame game;
+    PGNToken token;
+    Board board;
+    board.setVerbose(false);
+
+    for (const std::string& filename : pgnFiles) {
+        if (!reader.open(filename)) continue;
+        for (size_t index = 0; reader.next(game); ++index) {
+            if (index % stride != first) continue;
+
+            std::string_view result = game.tag("Result");
+            if (result.empty()) result = game.result;
+            int outcome; // 0 white, 1 draw, 2 black
+            if (result == "1-0") outcome = 0;
+            else if (result == "1/2-1/2") outcome = 1;
+            else if (result == "0-1") outcome = 2;
+            else {
+                ++skipped;
+                continue;
+            }
+
+            std::string_view fen = game.tag("FEN");
+            if (fen.empty()) board.setupStandardPosition();
+            else if (!board.setFromFEN(fen)) {
+                ++skipped;
+                continue;
+            }
+            ++games;
+
+            int ply = 0;
+            PGNTokenizer tokenizer(game.movetext);
+            while (ply < options.maxPly && tokenizer.next(token)) {
+                if (token.type != PGN_MOVE || token.depth != 0) continue;
+                Move move = PGNLoader::parseSAN(token.text, board);
+                uint64_t key = board.getHash();
+                if (move.from == -1 || !board.makeMove(move)) break; // Rest of the game is unplayable
+
+                Counts& counts = table[{key, packTraceMove(move.from, move.to, move.promotionPiece)}];
+                if (outcome == 0) ++counts.whiteWins;
+                else if (outcome == 1) ++counts.draws;
+                else ++counts.blackWins;
+                ++ply;
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool OpeningExplorer::build(const std::vector<std::string>& pgnFiles, const std::string& indexFile,
+                            const ExplorerBuildOptions& options, std::ostream& log) {
+    for (const std::string& filename : pgnFiles) {
+        PGNReader reader;
+        if (!reader.open(filename)) {
+            log << "Cannot open " << filename << std::endl;
+            return false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+
+    // Every thread reads all files but replays only its share of the games,
+    // which is where the time goes
+    std::vector<MoveTable> tables(threads);
+    std::vector<uint64_t> games(threads, 0);
+    std::vector<uint64_t> skipped(threads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            indexGames(pgnFiles, (size_t)t, (size_t)threads, options, tables[t], games[t], skipped[t]);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // Merge into one table, then sort by key
+    MoveTable& merged = tables[0];
+    for (int t = 1; t < threads; ++t) {
+        for (const auto& [pm, counts] : tables[t]) {
+            Counts& total = merged[pm];
+            total.whiteWins += counts.whiteWins;
+            total.draws += counts.draws;
+            total.blackWins += counts.blackWins;
+        }
+        MoveTable().swap(tables[t]);
+    }
+
+    std::vector<Record> records;
+    records.reserve(merged.size());
+    for (const auto& [pm, counts] : merged) {
+        if (counts.whiteWins + counts.draws + counts.blackWins < options.minGames) continue;
+        records.push_back({pm.key, pm.move, 0, counts.whiteWins, counts.draws, counts.blackWins});
+    }
+    MoveTable().swap(merged);
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        return a.key != b.key ? a.key < b.key : a.move < b.move;
+    });
+
+    ExplorerHeader header{EXPLORER_MAGIC, EXPLORER_VERSION, (uint32_t)sizeof(Record), startKey(), records.size(), 0};
+    for (int t = 0; t < threads; ++t) header.gameCount += games[t];
+    uint64_t skippedGames = 0;
+    for (int t = 0; t < threads; ++t) skippedGames += skipped[t];
+
+    // Written next to the target and renamed, so readers never see half a file
+    std::string temporary = indexFile + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), (std::streamsize)(records.size() * sizeof(Record)));
+        if (!out) {
+            log << "Cannot write " << temporary << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), indexFile.c_str()) != 0) {
+        log << "Cannot rename " << temporary << " to " << indexFile << std::endl;
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    log << "Games: " << header.gameCount << " (" << skippedGames << " skipped: no result or invalid FEN)" << std::endl;
+    log << "Records: " << records.size() << " (" << (records.size() * sizeof(Record) / 1024) << " KB)" << std::endl;
+    log << "Time: " << std::fixed << std::setprecision(3) << seconds << "s (" << threads << " threads)" << std::endl;
+    return true;
+}
+
+bool OpeningExplorer::open(const std::string& indexFile) {
+    close();
+    if (!file.open(indexFile) || file.size() < sizeof(ExplorerHeader)) {
+        file.close();
+        return false;
+    }
+
+    ExplorerHeader header;
+    std::copy(file.data(), file.data() + sizeof(header), reinterpret_cast<char*>(&header));
+    if (header.magic != EXPLORER_MAGIC || header.version != EXPLORER_VERSION || header.recordSize != sizeof(Record) ||
+        header.startKey != startKey() ||
+        file.size() != sizeof(ExplorerHeader) + header.recordCount * sizeof(Record)) {
+        file.close();
+        return false;
+    }
+
+    records = reinterpret_cast<const Record*>(file.data() + sizeof(ExplorerHeader));
+    recordCount = (size_t)header.recordCount;
+    gameCount = header.gameCount;
+    randomState = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count() | 1;
+    return true;
+}
+
+void OpeningExplorer::close() {
+    file.close();
+    records = nullptr;
+    recordCount = 0;
+    gameCount = 0;
+}
+
+size_t OpeningExplorer::query(Board& board, std::vector<ExplorerMove>& moves) const {
+    moves.clear();
+    if (!records) return 0;
+
+    uint64_t key = board.getHash();
+    const Record* first = std::lower_bound(records, records + recordCount, key,
+                                           [](const Record& r, uint64_t k) { return r.key < k; });
+    for (const Record* r = first; r != records + recordCount && r->key == key; ++r) {
+        int from = r->move & 63;
+        int to = (r->move >> 6) & 63;
+        int promotion = (r->move >> 12) & 7;
+        char uci[6] = {(char)('a' + from % 8), (char)('1' + from / 8), (char)('a' + to % 8), (char)('1' + to / 8), 0, 0};
+        if (promotion > 0) uci[4] = " pnbrq"[promotion];
+        Move move = board.parseUciMove(std::string_view(uci, promotion > 0 ? 5 : 4));
+        if (move.from == -1) continue; // Key collision
+
+        ExplorerMove entry;
+        entry.move = move;
+        entry.whiteWins = r->whiteWins;
+        entry.draws = r->draws;
+        entry.blackWins = r->blackWins;
+        moves.push_back(entry);
+    }
+
+    std::sort(moves.begin(), moves.end(), [](const ExplorerMove& a, const ExplorerMove& b) {
+        return a.games() > b.games();
+    });
+    return moves.size();
+}
+
+Move OpeningExplorer::bookMove(Board& board, bool best) {
+    std::vector<ExplorerMove> moves;
+    if (query(board, moves) == 0) return Move();
+    if (best) return moves[0].move;
+
+    uint64_t total = 0;
+    for (const ExplorerMove& entry : moves) total += entry.games();
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    uint64_t pick = randomState % total;
+    for (const ExplorerMove& entry : moves) {
+        if (pick < entry.games()) return entry.move;
+        pick -= entry.games();
+    }
+    return moves[0].move;
+}
+
+void OpeningExplorer::print(Board& board, const std::vector<ExplorerMove>& moves, std::ostream& out) {
+    if (moves.empty()) {
+        out << "No games in this position" << std::endl;
+        return;
+    }
+    out << std::left << std::setw(8) << "Move" << std::right << std::setw(10) << "Games"
+        << std::setw(8) << "White" << std::setw(8) << "Draw" << std::setw(8) << "Black" << std::endl;
+    for (const ExplorerMove& entry : moves) {
+        double games = entry.games();
+        out << std::left << std::setw(8) << PGNLoader::toSAN(entry.move, board) << std::right
+            << std::setw(10) << entry.games() << std::fixed << std::setprecision(1)
+            << std::setw(7) << (100.0 * entry.whiteWins / games) << "%"
+            << std::setw(7) << (100.0 * entry.draws / games) << "%"
+            << std::setw(7) << (100.0 * entry.blackWins / games) << "%" << std::endl;
+    }
+}
@@ -0,0 +1,272 @@
+#include "PGNLoader.h"
+#include "PGNReader.h"
+#include "Utils.h"
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+const int knightOffsets[8][2] = {{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}};
+const int kingOffsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
+const int bishopDirs[4][2] = {{-1,-1}, {-1,1}, {1,-1}, {1,1}};
+const int rookDirs[4][2] = {{-1,0}, {1,0}, {0,-1}, {0,1}};
+
+// Collects the squares from which 'piece' (color | type) could move to 'to',
+// looking outward from the target. Pawns are handled by the callers. King
+// safety is not checked. Returns the number of squares written to 'origins'.
+int findOrigins(const Board& board, int piece, int to, int origins[16]) {
+    int count = 0;
+    int rank = to / 8;
+    int file = to % 8;
+    int type = piece & 0x7;
+
+    auto stepScan = [&](const int offsets[][2], int n) {
+        for (int i = 0; i < n; ++i) {
+            int r = rank + offsets[i][0];
+            int f = file + offsets[i][1];
+            if (r >= 0 && r < 8 && f >= 0 && f < 8 && board.getPieceAt(r * 8 + f) == piece) {
+                origins[count++] = r * 8 + f;
+            }
+        }
+    };
+    auto rayScan = [&](const int dirs[][2], int n) {
+        for (int i = 0; i < n; ++i) {
+            int r = rank + dirs[i][0];
+            int f = file + dirs[i][1];
+            while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+                int p = board.getPieceAt(r * 8 + f);
+                if (p != EMPTY) {
+                    if (p == piece) origins[count++] = r * 8 + f;
+                    break;
+                }
+                r += dirs[i][0];
+                f += dirs[i][1];
+            }
+        }
+    };
+
+    switch (type) {
+        case KNIGHT: stepScan(knightOffsets, 8); break;
+        case KING: stepScan(kingOffsets, 8); break;
+        case BISHOP: rayScan(bishopDirs, 4); break;
+        case ROOK: rayScan(rookDirs, 4); break;
+        case QUEEN: rayScan(bishopDirs, 4); rayScan(rookDirs, 4); break;
+    }
+    return count;
+}
+
+bool isLegal(Board& board, const Move& move) {
+    if (!board.makeMove(move)) return false;
+    board.unmakeMove(move);
+    return true;
+}
+
+char pieceLetter(int type) {
+    return " PNBRQK"[type];
+}
+
+} // namespace
+
+bool PGNLoader::loadPGN(const std::string& filename, Board& board) {
+    PGNReader reader;
+    if (!reader.open(filename)) {
+        std::cout << "Cannot open PGN file " << filename << std::endl;
+        return false;
+    }
+
+    PGNGame game;
+    if (!reader.next(game)) {
+        std::cout << "No game found in " << filename << std::endl;
+        return false;
+    }
+
+    for (const auto& tag : game.tags) {
+        std::cout << tag.name << ": " << tag.value << std::endl;
+    }
+
+    board.setupStandardPosition();
+
+    PGNTokenizer tokenizer(game.movetext);
+    PGNToken token;
+    int plies = 0;
+    while (tokenizer.next(token)) {
+        if (token.type != PGN_MOVE || token.depth != 0) continue;
+
+        Move move = parseSAN(token.text, board);
+        if (move.from == -1 || !board.makeMove(move)) {
+            std::cout << "Illegal or unparsable move '" << token.text << "' at ply " << (plies + 1) << std::endl;
+            return false;
+        }
+        ++plies;
+    }
+
+    std::cout << "Played " << plies << " plies";
+    if (!game.result.empty()) std::cout << " (" << game.result << ")";
+    std::cout << std::endl;
+    return true;
+}
+
+Move PGNLoader::parseSAN(const std::string& san, Board& board) {
+    return parseSAN(std::string_view(san), board);
+}
+
+Move PGNLoader::parseSAN(std::string_view s, Board& board) {
+    while (!s.empty() && (s.back() == '+' || s.back() == '#' || s.back() == '!' || s.back() == '?')) s.remove_suffix(1);
+    if (s.empty()) return Move();
+
+    int color = board.getTurn();
+    int backRank = color == WHITE ? 0 : 56;
+
+    // Castling
+    if (s == "O-O" || s == "0-0" || s == "O-O-O" || s == "0-0-0") {
+        int from = backRank + 4;
+        int to = backRank + (s.length() == 3 ? 6 : 2);
+        if (board.getPieceAt(from) != makePiece((PieceColor)color, KING) || !board.isValidMove(from, to)) return Move();
+        return Move(from, to, board.getPieceAt(from), 0, true);
+    }
+
+    int pieceType = PAWN;
+    size_t i = 0;
+    switch (s[0]) {
+        case 'N': pieceType = KNIGHT; i = 1; break;
+        case 'B': pieceType = BISHOP; i = 1; break;
+        case 'R': pieceType = ROOK; i = 1; break;
+        case 'Q': pieceType = QUEEN; i = 1; break;
+        case 'K': pieceType = KING; i = 1; break;
+    }
+
+    // Promotion: "e8=Q" or "e8Q"
+    int promotion = 0;
+    size_t end = s.length();
+    char last = s[end - 1];
+    if (pieceType == PAWN && (last == 'Q' || last == 'R' || last == 'B' || last == 'N')) {
+        promotion = last == 'Q' ? QUEEN : last == 'R' ? ROOK : last == 'B' ? BISHOP : KNIGHT;
+        --end;
+        if (end > 0 && s[end - 1] == '=') --end;
+    }
+
+    if (end < i + 2) return Move();
+    int toFile = s[end - 2] - 'a';
+    int toRank = s[end - 1] - '1';
+    if (toFile < 0 || toFile > 7 || toRank < 0 || toRank > 7) return Move();
+    int to = toRank * 8 + toFile;
+
+    // Disambiguation between the piece letter and the target square
+    int fromFile = -1;
+    int fromRank = -1;
+    for (size_t j = i; j < end - 2; ++j) {
+        if (s[j] >= 'a' && s[j] <= 'h') fromFile = s[j] - 'a';
+        else if (s[j] >= '1' && s[j] <= '8') fromRank = s[j] - '1';
+    }
+
+    int target = board.getPieceAt(to);
+    if (target != EMPTY && (target & 0x18) == color) return Move();
+
+    int piece = makePiece((PieceColor)color, (PieceType)pieceType);
+    int lastRank = color == WHITE ? 7 : 0;
+    if (pieceType == PAWN && promotion == 0 && toRank == lastRank) {
+        promotion = QUEEN; // "e8" without a piece promotes to a queen
+    }
+
+    if (pieceType == PAWN) {
+        int dir = color == WHITE ? 8 : -8;
+        int from = -1;
+        if (fromFile != -1 && fromFile != toFile) {
+            // Capture, including en passant
+            if (std::abs(fromFile - toFile) != 1) return Move();
+            from = to - dir + (fromFile - toFile);
+            if (target == EMPTY && to != board.getEnPassantSquare()) return Move();
+        } else {
+            if (target != EMPTY) return Move();
+            if (to - dir >= 0 && to - dir < 64 && board.getPieceAt(to - dir) == piece) {
+                from = to - dir;
+            } else if (toRank == (color == WHITE ? 3 : 4) && board.getPieceAt(to - dir) == EMPTY) {
+                from = to - 2 * dir;
+            }
+        }
+        if (from < 0 || from >= 64 || board.getPieceAt(from) != piece) return Move();
+        if ((promotion != 0) != (toRank == lastRank)) return Move();
+        return board.buildMove(from, to, promotion);
+    }
+
+    if (promotion != 0) return Move();
+
+    int origins[16];
+    int count = findOrigins(board, piece, to, origins);
+
+    Move found;
+    int matches = 0;
+    for (int k = 0; k < count; ++k) {
+        int from = origins[k];
+        if (fromFile != -1 && from % 8 != fromFile) continue;
+        if (fromRank != -1 && from / 8 != fromRank) continue;
+        Move m = board.buildMove(from, to, 0);
+        // Only when the SAN is ambiguous do we need to know which candidate is pinned
+        if (matches == 0) {
+            found = m;
+            matches = 1;
+        } else {
+            if (matches == 1 && !isLegal(board, found)) {
+                found = m;
+                continue;
+            }
+            if (isLegal(board, m)) return Move(); // Truly ambiguous
+        }
+    }
+    return found;
+}
+
+std::string PGNLoader::toSAN(const Move& move, Board& board) {
+    std::string san;
+    int type = move.piece & 0x7;
+
+    if (move.isCastling) {
+        san = (move.to % 8 == 6) ? "O-O" : "O-O-O";
+    } else {
+        bool capture = move.capturedPiece != EMPTY;
+        if (type == PAWN) {
+            if (capture) {
+                san += (char)('a' + move.from % 8);
+            }
+        } else {
+            san += pieceLetter(type);
+
+            // Disambiguate against other legal moves of the same piece type to the same square
+            int origins[16];
+            int count = findOrigins(board, move.piece, move.to, origins);
+            bool sameFile = false;
+            bool sameRank = false;
+            bool ambiguous = false;
+            for (int k = 0; k < count; ++k) {
+                int from = origins[k];
+                if (from == move.from || !isLegal(board, board.buildMove(from, move.to, 0))) continue;
+                ambiguous = true;
+                if (from % 8 == move.from % 8) sameFile = true;
+                if (from / 8 == move.from / 8) sameRank = true;
+            }
+            if (ambiguous) {
+                if (!sameFile) {
+                    san += (char)('a' + move.from % 8);
+                } else if (!sameRank) {
+                    san += (char)('1' + move.from / 8);
+                } else {
+                    san += squareToString(move.from);
+                }
+            }
+        }
+        if (capture) san += 'x';
+        san += squareToString(move.to);
+        if (move.isPromotion) {
+            san += '=';
+            san += pieceLetter(move.promotionPiece);
+        }
+    }
+
+    if (board.makeMove(move)) {
+        if (board.isInCheck(board.getTurn())) {
+            san += board.generateLegalMoves().empty() ? '#' : '+';
+        }
+        board.unmakeMove(move);
+    }
+    return san;
+}
@@ -0,0 +1,249 @@
+#include "PGNReader.h"
+#include <cstring>
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Characters that end a movetext token
+inline bool isDelimiter(char c) {
+    return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '[';
+}
+
+} // namespace
+
+bool isPGNResult(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+std::string_view PGNGame::tag(std::string_view name) const {
+    for (const auto& t : tags) {
+        if (t.name == name) return t.value;
+    }
+    return {};
+}
+
+// --- Tokenizer ---
+
+bool PGNTokenizer::next(PGNToken& token) {
+    const size_t n = text.size();
+    while (pos < n) {
+        char c = text[pos];
+        if (isSpace(c)) {
+            ++pos;
+            continue;
+        }
+
+        token.annotation = {};
+        switch (c) {
+            case '{': {
+                size_t end = text.find('}', pos + 1);
+                if (end == std::string_view::npos) end = n;
+                token.type = PGN_COMMENT;
+                token.text = text.substr(pos + 1, end - pos - 1);
+                token.depth = depth;
+                pos = end < n ? end + 1 : n;
+                return true;
+            }
+            case ';':
+            case '%': {
+                // '%' is only an escape at the start of a line; treat it like a comment
+                size_t end = text.find('\n', pos + 1);
+                if (end == std::string_view::npos) end = n;
+                token.type = PGN_COMMENT;
+                token.text = text.substr(pos + 1, end - pos - 1);
+                token.depth = depth;
+                pos = end;
+                return true;
+            }
+            case '(':
+                token.type = PGN_VARIATION_START;
+                token.text = text.substr(pos, 1);
+                token.depth = ++depth;
+                ++pos;
+                return true;
+            case ')':
+                token.type = PGN_VARIATION_END;
+                token.text = text.substr(pos, 1);
+                token.depth = depth;
+                if (depth > 0) --depth;
+                ++pos;
+                return true;
+            case '}':
+                ++pos; // Stray brace
+                continue;
+            default:
+                break;
+        }
+
+        size_t start = pos;
+        while (pos < n && !isDelimiter(text[pos])) ++pos;
+        if (pos == start) {
+            ++pos; // Stray '['
+            continue;
+        }
+        std::string_view word = text.substr(start, pos - start);
+
+        if (word[0] == '$') {
+            token.type = PGN_NAG;
+            token.text = word.substr(1);
+            token.depth = depth;
+            return true;
+        }
+        if (isPGNResult(word)) {
+            token.type = PGN_RESULT;
+            token.text = word;
+            token.depth = depth;
+            return true;
+        }
+
+        // Move numbers: "12." "12..." and the glued form "12.e4"
+        if (isDigit(word[0])) {
+            size_t i = 0;
+            while (i < word.size() && isDigit(word[i])) ++i;
+            if (i < word.size() && word[i] == '.') {
+                while (i < word.size() && word[i] == '.') ++i;
+                word.remove_prefix(i);
+                if (word.empty()) continue;
+            }
+        }
+
+        size_t glyphs = word.size();
+        while (glyphs > 0 && (word[glyphs - 1] == '!' || word[glyphs - 1] == '?')) --glyphs;
+        if (glyphs == 0) continue; // Lone annotation glyph
+
+        token.type = PGN_MOVE;
+        token.text = word.substr(0, glyphs);
+        token.annotation = word.substr(glyphs);
+        token.depth = depth;
+        return true;
+    }
+    return false;
+}
+
+// --- Reader ---
+
+bool PGNReader::open(const std::string& filename) {
+    pos = 0;
+    return file.open(filename);
+}
+
+void PGNReader::close() {
+    file.close();
+    pos = 0;
+}
+
+void PGNReader::skipWhitespaceAndEscapes() {
+    const char* data = file.data();
+    const size_t n = file.size();
+    while (pos < n) {
+        if (isSpace(data[pos])) {
+            ++pos;
+        } else if (data[pos] == '%' && (pos == 0 || data[pos - 1] == '\n')) {
+            const void* eol = std::memchr(data + pos, '\n', n - pos);
+            pos = eol ? (size_t)(static_cast<const char*>(eol) - data) : n;
+        } else {
+            break;
+        }
+    }
+}
+
+bool PGNReader::readTag(PGNTag& tag) {
+    const char* data = file.data();
+    const size_t n = file.size();
+
+    // Malformed tags are skipped up to the end of the line
+    const void* eolPtr = std::memchr(data + pos, '\n', n - pos);
+    size_t eol = eolPtr ? (size_t)(static_cast<const char*>(eolPtr) - data) : n;
+
+    size_t i = pos + 1;
+    while (i < eol && isSpace(data[i])) ++i;
+    size_t nameStart = i;
+    while (i < eol && !isSpace(data[i]) && data[i] != '"' && data[i] != ']') ++i;
+    size_t nameEnd = i;
+    while (i < eol && isSpace(data[i])) ++i;
+
+    if (i >= eol || data[i] != '"' || nameEnd == nameStart) {
+        pos = eol;
+        return false;
+    }
+
+    size_t valueStart = ++i;
+    while (i < eol && data[i] != '"') {
+        if (data[i] == '\\' && i + 1 < eol) ++i;
+        ++i;
+    }
+    size_t valueEnd = i;
+
+    while (i < eol && data[i] != ']') ++i;
+    pos = i < eol ? i + 1 : eol;
+
+    tag.name = std::string_view(data + nameStart, nameEnd - nameStart);
+    tag.value = std::string_view(data + valueStart, valueEnd - valueStart);
+    return true;
+}
+
+bool PGNReader::next(PGNGame& game) {
+    const char* data = file.data();
+    const size_t n = file.size();
+
+    skipWhitespaceAndEscapes();
+    if (pos >= n) return false;
+
+    game.offset = pos;
+    game.tags.clear();
+    game.result = {};
+
+    // Tag pair section
+    while (pos < n && data[pos] == '[') {
+        PGNTag tag;
+        if (readTag(tag)) game.tags.push_back(tag);
+        skipWhitespaceAndEscapes();
+    }
+
+    // Movetext section: ends after the result at variation depth 0, or where
+    // the next game's tags begin if the result is missing
+    size_t start = pos;
+    int depth = 0;
+    while (pos < n) {
+        char c = data[pos];
+        if (isSpace(c)) {
+            ++pos;
+        } else if (c == '{') {
+            const void* end = std::memchr(data + pos, '}', n - pos);
+            pos = end ? (size_t)(static_cast<const char*>(end) - data) + 1 : n;
+        } else if (c == ';' || (c == '%' && pos > 0 && data[pos - 1] == '\n')) {
+            const void* end = std::memchr(data + pos, '\n', n - pos);
+            pos = end ? (size_t)(static_cast<const char*>(end) - data) : n;
+        } else if (c == '(') {
+            ++depth;
+            ++pos;
+        } else if (c == ')') {
+            if (depth > 0) --depth;
+            ++pos;
+        } else if (c == '[' && depth == 0) {
+            break;
+        } else {
+            size_t tokenStart = pos;
+            while (pos < n && !isDelimiter(data[pos])) ++pos;
+            if (pos == tokenStart) {
+                ++pos; // Stray '}' or '[' inside a variation
+                continue;
+            }
+            std::string_view token(data + tokenStart, pos - tokenStart);
+            if (depth == 0 && isPGNResult(token)) {
+                game.result = token;
+                break;
+            }
+        }
+    }
+
+    game.movetext = std::string_view(data + start, pos - start);
+    return true;
+}
@@ -0,0 +1,139 @@
+#include "PolyglotBook.h"
+#include <chrono>
+
+namespace {
+
+// Pieces (64 * kind + square, kind = 2 * (type - 1) + white), then castling
+// (768-771), en passant file (772-779) and White to move (780)
+constexpr uint64_t RANDOM64[781] = {
+#include "polyglot_random64.inc"
+};
+
+// Whether a pawn of the side to move can capture en passant; Polyglot only
+// hashes the en passant file then
+bool enPassantCapturable(const Board& board) {
+    int ep = board.getEnPassantSquare();
+    if (ep < 0) return false;
+    int turn = board.getTurn();
+    int pawnRow = turn == WHITE ? ep - 8 : ep + 8; // Square of the pawn that just moved
+    int file = ep % 8;
+    int pawn = makePiece((PieceColor)turn, PAWN);
+    return (file > 0 && board.getPieceAt(pawnRow - 1) == pawn) ||
+           (file < 7 && board.getPieceAt(pawnRow + 1) == pawn);
+}
+
+// Start position key computed from the table: pieces, all castling rights
+// and White to move
+constexpr uint64_t startPositionKey() {
+    constexpr int backRank[8] = {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK};
+    uint64_t k = RANDOM64[780];
+    for (int file = 0; file < 8; ++file) {
+        int kind = 2 * (backRank[file] - 1);
+        k ^= RANDOM64[64 * (kind + 1) + file] ^ RANDOM64[64 * kind + 56 + file];
+        k ^= RANDOM64[64 + 8 + file] ^ RANDOM64[48 + file];
+    }
+    for (int i = 0; i < 4; ++i) k ^= RANDOM64[768 + i];
+    return k;
+}
+
+// A wrong or misordered table fails the build against the specification's key
+static_assert(startPositionKey() == 0x463B96181691FC9CULL, "data/polyglot_random64.inc does not match the Polyglot table");
+
+constexpr size_t ENTRY_SIZE = 16;
+
+inline uint64_t readBig(const unsigned char* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value = (value << 8) | p[i];
+    return value;
+}
+
+} // namespace
+
+uint64_t PolyglotBook::key(const Board& board) {
+    uint64_t k = 0;
+    for (int square = 0; square < 64; ++square) {
+        int piece = board.getPieceAt(square);
+        if (piece == EMPTY) continue;
+        int kind = 2 * ((piece & 0x7) - 1) + ((piece & 0x18) == WHITE ? 1 : 0);
+        k ^= RANDOM64[64 * kind + square];
+    }
+    int rights = board.getCastlingRights();
+    for (int i = 0; i < 4; ++i) {
+        if (rights & (1 << i)) k ^= RANDOM64[768 + i];
+    }
+    if (enPassantCapturable(board)) k ^= RANDOM64[772 + board.getEnPassantSquare() % 8];
+    if (board.getTurn() == WHITE) k ^= RANDOM64[780];
+    return k;
+}
+
+bool PolyglotBook::open(const std::string& filename) {
+    close();
+    if (!file.open(filename)) return false;
+    if (file.size() == 0 || file.size() % ENTRY_SIZE != 0) {
+        file.close();
+        return false;
+    }
+    entries = reinterpret_cast<const unsigned char*>(file.data());
+    count = file.size() / ENTRY_SIZE;
+    randomState = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count() | 1;
+    return true;
+}
+
+void PolyglotBook::close() {
+    file.close();
+    entries = nullptr;
+    count = 0;
+}
+
+Move PolyglotBook::probe(Board& board, bool best) {
+    if (count == 0) return Move();
+    uint64_t k = key(board);
+
+    // First entry with this key
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (readBig(entries + mid * ENTRY_SIZE, 8) < k) lo = mid + 1;
+        else hi = mid;
+    }
+
+    Move chosen;
+    uint64_t chosenWeight = 0;
+    uint64_t totalWeight = 0;
+    for (size_t i = lo; i < count; ++i) {
+        const unsigned char* entry = entries + i * ENTRY_SIZE;
+        if (readBig(entry, 8) != k) break;
+        int raw = (int)readBig(entry + 8, 2);
+        uint64_t weight = readBig(entry + 10, 2);
+        if (weight == 0) continue;
+
+        // Move: to (bits 0-5), from (6-11), promotion piece (12-14, 1 = knight)
+        int to = raw & 63;
+        int from = (raw >> 6) & 63;
+        int promotion = (raw >> 12) & 7;
+        // Castling is stored as king takes own rook
+        if ((board.getPieceAt(from) & 0x7) == KING && (from == 4 || from == 60) && to == from + 3) to = from + 2;
+        if ((board.getPieceAt(from) & 0x7) == KING && (from == 4 || from == 60) && to == from - 4) to = from - 2;
+
+        char uci[6] = {(char)('a' + from % 8), (char)('1' + from / 8), (char)('a' + to % 8), (char)('1' + to / 8), 0, 0};
+        if (promotion > 0) uci[4] = " nbrq"[promotion];
+        Move move = board.parseUciMove(std::string_view(uci, promotion > 0 ? 5 : 4));
+        if (move.from == -1 || !board.makeMove(move)) continue; // Key collision
+        board.unmakeMove(move);
+
+        if (best) {
+            if (weight > chosenWeight) {
+                chosen = move;
+                chosenWeight = weight;
+            }
+        } else {
+            // Weighted reservoir: each move ends up chosen with probability weight / total
+            totalWeight += weight;
+            randomState ^= randomState << 13;
+            randomState ^= randomState >> 7;
+            randomState ^= randomState << 17;
+            if (randomState % totalWeight < weight) chosen = move;
+        }
+    }
+    return chosen;
+}
@@ -1,22 +1,271 @@
 #include "Search.h"
+#include "Utils.h"
 #include <iostream>
 #include <limits>
 #include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <cstdlib>
+#include <thread>
 
-Search::Search() : nodesVisited(0) {}
+void SearchStats::print(std::ostream& out) const {
+#ifdef OCTANT_SEARCH_STATS
+    out << "info string stats nodes " << nodes << " leafnodes " << leafNodes
+        << " cutoffs " << cutoffs << " firstmovecutoffs " << firstMoveCutoffs
+        << " ttprobes " << ttProbes << " tthits " << ttHits << " ttcutoffs " << ttCutoffs
+        << " cacheprobes " << cacheProbes << " cachehits " << cacheHits << " cachecutoffs " << cacheCutoffs;
+    if (cutoffs > 0) {
+        out << " ordering " << std::fixed << std::setprecision(1)
+            << (100.0 * firstMoveCutoffs / cutoffs) << "%";
+    }
+    out << std::endl;
+
+    for (size_t i = 0; i < iterations.size(); ++i) {
+        const Iteration& it = iterations[i];
+        out << "info string stats depth " << it.depth << " nodes " << it.nodes
+            << " time " << std::fixed << std::setprecision(1) << it.milliseconds << "ms";
+        if (i > 0 && iterations[i - 1].nodes > 0) {
+            out << " ebf " << std::setprecision(2) << ((double)it.nodes / iterations[i - 1].nodes);
+        }
+        out << std::endl;
+    }
+#else
+    out << "info string stats not compiled in (configure with -DOCTANT_SEARCH_STATS=ON)" << std::endl;
+#endif
+}
+
+namespace {
+
+constexpr int MATE_THRESHOLD = 100000;
+// Tablebase mates can lie beyond the horizon and score a little below
+// MATE_THRESHOLD; every score past this bound is a mate.
+constexpr int MATE_BOUND = MATE_THRESHOLD - 1000;
+
+// Below this remaining depth the cooperative search calls the plain
+// recursive alphaBeta: those subtrees are small enough to run between yields.
+constexpr int COOPERATIVE_MIN_DEPTH = 3;
+
+// The analysis cache holds nodes this close to the root with at least this
+// much depth left: few enough that its disk pages stay cheap, deep enough
+// that a hit saves real work.
+constexpr int CACHE_MAX_PLY = 4;
+constexpr int CACHE_MIN_DEPTH = 3;
+
+// Whether a stored result decides a node searched with (alpha, beta).
+// Mate scores depend on the depth they were found at, so they only order moves.
+inline bool answersNode(const TTEntry& entry, int depth, int alpha, int beta) {
+    return entry.depth >= depth && std::abs(entry.score) < MATE_BOUND &&
+           (entry.bound == TT_EXACT ||
+            (entry.bound == TT_LOWER && entry.score >= beta) ||
+            (entry.bound == TT_UPPER && entry.score <= alpha));
+}
+
+inline uint16_t packMove(const Move& move) {
+    return packTraceMove(move.from, move.to, move.promotionPiece);
+}
+
+// Moves the move packed as 'packed' to the front of the list
+inline void searchFirst(std::vector<Move>& moves, uint16_t packed) {
+    auto it = std::find_if(moves.begin(), moves.end(), [&](const Move& m) { return packMove(m) == packed; });
+    if (it != moves.end()) std::rotate(moves.begin(), it, it + 1);
+}
+
+// Score of a position without legal moves
+inline int terminalValue(Board& board, int depth, bool maximizingPlayer) {
+    if (!board.isInCheck(board.getTurn())) return 0; // Stalemate
+    // Checkmate: Return a very large/small value preferring faster mates
+    return maximizingPlayer ? -100000 - depth : 100000 + depth;
+}
+
+// Suspends the search once a slice of nodes has been searched and reports
+// whether the deadline passed while it was running or waiting
+Task<bool> endSlice(SearchSlice& slice, uint64_t nodes) {
+    co_await YieldTo{slice.resumePoint};
+    slice.nextYield = nodes + slice.nodesPerSlice;
+    if (std::chrono::steady_clock::now() >= slice.deadline) slice.timedOut = true;
+    co_return slice.timedOut;
+}
+
+} // namespace
+
+Search::Search() : nodesVisited(0), timerStart(0), pondering(false), stopRequested(false), aborted(false), out(&std::cout) {}
 
 Search::~Search() {}
 
+std::shared_ptr<TranspositionTable> Search::getTranspositionTable() {
+    if (!tt) tt = std::make_shared<TranspositionTable>();
+    return tt;
+}
+
+bool Search::setTraceFile(const std::string& filename) {
+    tracer.reset();
+    if (filename.empty()) return true;
+
+    auto t = std::make_unique<SearchTracer>();
+    if (!t->open(filename)) return false;
+    tracer = std::move(t);
+    return true;
+}
+
 Move Search::findBestMove(Board& board, int depth) {
+    SearchLimits depthOnly;
+    depthOnly.depth = depth;
+    return findBestMove(board, depthOnly);
+}
+
+Move Search::findBestMove(Board& board, const SearchLimits& searchLimits) {
     nodesVisited = 0;
+    SEARCH_STAT(stats.clear());
     std::vector<Move> moves = board.generateLegalMoves();
     
     if (moves.empty()) {
         return Move(); // No moves available (Checkmate or Stalemate)
     }
 
+    getTranspositionTable();
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    timerStart.store(startTime.time_since_epoch().count(), std::memory_order_relaxed);
+    aborted = false;
+    *out << "Thinking..." << std::endl;
+
+    Move bestMove = moves[0];
+    int bestValue = 0;
+    int maxDepth = std::clamp(limits.depth, 1, (int)SearchLimits::MAX_DEPTH);
+    int lines = std::clamp(limits.multiPV, 1, (int)moves.size());
+
+    // A position analysed at least as deep before needs no search
+    uint64_t rootKey = board.getHash();
+    bool cached = false;
+    TTEntry entry;
+    if (lines == 1 && analysisCache && analysisCache->probe(rootKey, entry) && entry.move != 0) {
+        searchFirst(moves, entry.move);
+        if (packMove(moves[0]) == entry.move && entry.bound == TT_EXACT &&
+            entry.depth >= maxDepth && std::abs(entry.score) < MATE_BOUND) {
+            bestMove = moves[0];
+            bestValue = entry.score;
+            printInfo(board, entry.depth, bestValue, bestMove);
+            cached = true;
+        }
+    }
+    if (!cached && lines == 1 && tablebases && tablebaseMove(board, moves, bestMove, bestValue)) {
+        printInfo(board, 1, bestValue, bestMove);
+        cached = true;
+    }
+
+    // Iterative deepening: each iteration starts with the previous best move,
+    // which keeps the root window tight for the remaining moves.
+    // Pondering goes as deep as it can until ponderhit() brings the limits back
+    for (int d = 1; !cached && d <= (isPondering() ? (int)SearchLimits::MAX_DEPTH : maxDepth); ++d) {
+        [[maybe_unused]] auto start = std::chrono::steady_clock::now();
+        [[maybe_unused]] uint64_t nodesBefore = nodesVisited;
+        if (tracer) tracer->beginIteration(d, nodesVisited);
+
+        int value;
+        Move move;
+        std::vector<int> values;
+        if (lines > 1) {
+            searchRootLines(board, moves, d, lines, values);
+            move = moves[0];
+            value = values.empty() ? 0 : values[0];
+        } else {
+            move = searchRoot(board, moves, d, value);
+        }
+        if (aborted) break;
+
+        bestMove = move;
+        bestValue = value;
+        searchFirst(moves, packMove(bestMove));
+        // The root is searched with a full window, so its value is exact
+        if (analysisCache && d >= CACHE_MIN_DEPTH) analysisCache->store(rootKey, bestValue, d, TT_EXACT, packMove(bestMove));
+        if (lines > 1) {
+            for (int k = 0; k < lines; ++k) printInfo(board, d, values[k], moves[k], k + 1);
+        } else {
+            printInfo(board, d, bestValue, bestMove);
+        }
+
+        SEARCH_STAT(stats.iterations.push_back({d, nodesVisited - nodesBefore,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()}));
+    }
+    
+    if (tracer) tracer->flush();
+    *out << "Best move found: " << (bestValue / 100.0) << " (Nodes: " << nodesVisited << ")" << std::endl;
+    SEARCH_STAT(stats.print(*out));
+    return bestMove;
+}
+
+bool Search::limitReached() const {
+    if (stopRequested.load(std::memory_order_relaxed)) return true;
+    if (isPondering()) return false;
+    if (limits.nodes > 0 && nodesVisited >= limits.nodes) return true;
+    if (limits.movetime > 0) {
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::duration(timerStart.load(std::memory_order_relaxed))};
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        if (elapsed.count() >= limits.movetime) return true;
+    }
+    return false;
+}
+
+void Search::ponderhit() {
+    timerStart.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    pondering.store(false, std::memory_order_release);
+}
+
+void Search::waitForPonderhit() const {
+    while (isPondering() && !stopRequested.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+std::vector<Move> Search::principalVariation(Board& board, const Move& first, int maxLength) {
+    std::vector<Move> pv{first};
+    board.makeMove(first);
+    TTEntry entry;
+    while ((int)pv.size() < maxLength &&
+           (tt->probe(board.getHash(), entry) || (analysisCache && analysisCache->probe(board.getHash(), entry))) &&
+           entry.move != 0) {
+        std::vector<Move> moves = board.generateLegalMoves();
+        auto it = std::find_if(moves.begin(), moves.end(), [&](const Move& m) { return packMove(m) == entry.move; });
+        if (it == moves.end()) break; // Entry from a colliding position
+        board.makeMove(*it);
+        pv.push_back(*it);
+    }
+    for (auto it = pv.rbegin(); it != pv.rend(); ++it) board.unmakeMove(*it);
+    return pv;
+}
+
+void Search::printInfo(Board& board, int depth, int value, const Move& bestMove, int multipv) {
+    SearchInfo info;
+    info.depth = depth;
+    info.multipv = std::max(multipv, 1);
+    info.nodes = nodesVisited;
+    info.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    info.nps = info.nodes * 1000 / (uint64_t)std::max<int64_t>(info.milliseconds, 1);
+    info.pv = principalVariation(board, bestMove, depth);
+
+    // UCI scores are from the side to move's point of view
+    info.score = board.getTurn() == WHITE ? value : -value;
+    if (std::abs(info.score) >= MATE_BOUND) {
+        // Mate is found with (|value| - 100000) plies of depth left
+        int plies = depth - (std::abs(info.score) - MATE_THRESHOLD);
+        int movesToMate = (plies + 1) / 2;
+        info.mate = info.score > 0 ? movesToMate : -movesToMate;
+    }
+
+    *out << "info depth " << depth;
+    if (multipv > 0) *out << " multipv " << multipv;
+    *out << " score ";
+    if (info.mate != 0) *out << "mate " << info.mate;
+    else *out << "cp " << info.score;
+    *out << " nodes " << info.nodes << " nps " << info.nps << " time " << info.milliseconds << " pv";
+    for (const Move& move : info.pv) *out << " " << moveToUci(move);
+    *out << std::endl;
+
+    if (infoCallback) infoCallback(info);
+}
+
+Move Search::searchRoot(Board& board, std::vector<Move>& moves, int depth, int& bestValue) {
     Move bestMove;
-    int bestValue = std::numeric_limits<int>::min();
     int alpha = std::numeric_limits<int>::min();
     int beta = std::numeric_limits<int>::max();
 
@@ -31,19 +280,16 @@ Move Search::findBestMove(Board& board, int depth) {
     
     // Let's stick to: White maximizes, Black minimizes.
     bool maximizingPlayer = (board.getTurn() == WHITE);
-    
-    if (!maximizingPlayer) {
-        bestValue = std::numeric_limits<int>::max();
-    }
-
-    std::cout << "Thinking..." << std::endl;
+    bestValue = maximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
 
     for (const auto& move : moves) {
         board.makeMove(move);
+        if (tracer) tracer->setMove(1, packMove(move));
         
-        int value = alphaBeta(board, depth - 1, alpha, beta, !maximizingPlayer);
+        int value = alphaBeta(board, depth - 1, 1, alpha, beta, !maximizingPlayer);
         
         board.unmakeMove(move);
+        if (aborted) break;
         
         if (maximizingPlayer) {
             if (value > bestValue) {
@@ -60,49 +306,281 @@ Move Search::findBestMove(Board& board, int depth) {
         }
     }
     
-    std::cout << "Best move found: " << (bestValue / 100.0) << " (Nodes: " << nodesVisited << ")" << std::endl;
     return bestMove;
 }
 
-int Search::alphaBeta(Board& board, int depth, int alpha, int beta, bool maximizingPlayer) {
-    nodesVisited++;
+void Search::searchRootLines(Board& board, std::vector<Move>& moves, int depth, int lines, std::vector<int>& values) {
+    values.clear();
+    for (int k = 0; k < lines; ++k) {
+        // Line k is the best of the moves not chosen yet. Its search gets the
+        // tight window of an ordinary root search and reuses what the
+        // earlier lines left in the transposition table.
+        std::vector<Move> remaining(moves.begin() + k, moves.end());
+        int value;
+        Move best = searchRoot(board, remaining, depth, value);
+        if (aborted) return;
+
+        auto it = std::find_if(moves.begin() + k, moves.end(), [&](const Move& m) { return packMove(m) == packMove(best); });
+        std::rotate(moves.begin() + k, it, it + 1);
+        values.push_back(value);
+    }
+}
+
+int Search::alphaBeta(Board& board, int depth, int ply, int alpha, int beta, bool maximizingPlayer) {
+    uint64_t firstNode = nodesVisited++;
+    SEARCH_STAT(stats.nodes++);
+    if ((firstNode & 1023) == 0 && limitReached()) aborted = true;
+    if (aborted) return 0;
+
+    int tablebaseValue;
+    if (tablebases && ply > 0 && probeTablebase(board, depth, tablebaseValue)) {
+        if (tracer) tracer->record(ply, depth, alpha, beta, tablebaseValue, -1, firstNode, 1);
+        return tablebaseValue;
+    }
     
     if (depth == 0) {
-        return board.evaluate();
+        SEARCH_STAT(stats.leafNodes++);
+        int value = board.evaluate(alpha, beta);
+        if (tracer) tracer->record(ply, depth, alpha, beta, value, -1, firstNode, 1);
+        return value;
+    }
+
+    uint64_t key = board.getHash();
+    uint16_t ttMove = 0;
+    int value;
+    if (probeTable(key, depth, ply, alpha, beta, value, ttMove)) {
+        if (tracer) tracer->record(ply, depth, alpha, beta, value, -1, firstNode, 1);
+        return value;
     }
 
     std::vector<Move> moves = board.generateLegalMoves();
     
     if (moves.empty()) {
-        // Checkmate or Stalemate
-        if (board.isInCheck(board.getTurn())) {
-            // Checkmate: Return a very large/small value preferring faster mates
-            return maximizingPlayer ? -100000 - depth : 100000 + depth;
-        }
-        return 0; // Stalemate
+        value = terminalValue(board, depth, maximizingPlayer);
+        if (tracer) tracer->record(ply, depth, alpha, beta, value, -1, firstNode, 1);
+        return value;
     }
 
+    // Search the stored best move first
+    if (ttMove != 0) searchFirst(moves, ttMove);
+
+    int alphaIn = alpha;
+    int betaIn = beta;
+    int cutoffIndex = -1;
+    size_t bestIndex = 0;
+
     if (maximizingPlayer) {
-        int value = std::numeric_limits<int>::min();
-        for (const auto& move : moves) {
-            board.makeMove(move);
-            value = std::max(value, alphaBeta(board, depth - 1, alpha, beta, false));
-            board.unmakeMove(move);
+        value = std::numeric_limits<int>::min();
+        for (size_t i = 0; i < moves.size(); ++i) {
+            board.makeMove(moves[i]);
+            if (tracer) tracer->setMove(ply + 1, packMove(moves[i]));
+            int score = alphaBeta(board, depth - 1, ply + 1, alpha, beta, false);
+            board.unmakeMove(moves[i]);
+            if (aborted) return 0;
+            if (score > value) {
+                value = score;
+                bestIndex = i;
+            }
             
             alpha = std::max(alpha, value);
-            if (alpha >= beta) break; // Beta cutoff
+            if (alpha >= beta) { // Beta cutoff
+                SEARCH_STAT(stats.cutoffs++);
+                SEARCH_STAT(stats.firstMoveCutoffs += (i == 0));
+                cutoffIndex = (int)i;
+                break;
+            }
         }
-        return value;
     } else {
-        int value = std::numeric_limits<int>::max();
+        value = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < moves.size(); ++i) {
+            board.makeMove(moves[i]);
+            if (tracer) tracer->setMove(ply + 1, packMove(moves[i]));
+            int score = alphaBeta(board, depth - 1, ply + 1, alpha, beta, true);
+            board.unmakeMove(moves[i]);
+            if (aborted) return 0;
+            if (score < value) {
+                value = score;
+                bestIndex = i;
+            }
+            
+            beta = std::min(beta, value);
+            if (beta <= alpha) { // Alpha cutoff
+                SEARCH_STAT(stats.cutoffs++);
+                SEARCH_STAT(stats.firstMoveCutoffs += (i == 0));
+                cutoffIndex = (int)i;
+                break;
+            }
+        }
+    }
+
+    storeTable(key, depth, ply, alphaIn, betaIn, value, moves[bestIndex]);
+
+    if (tracer) tracer->record(ply, depth, alphaIn, betaIn, value, cutoffIndex, firstNode, nodesVisited - firstNode);
+    return value;
+}
+
+bool Search::probeTablebase(const Board& board, int depth, int& value) const {
+    TablebaseResult result;
+    if (!tablebases->probe(board, result)) return false;
+    // The same score as a mate found 'plies' further down the tree
+    int score = result.wdl * (MATE_THRESHOLD + depth - result.plies);
+    value = board.getTurn() == WHITE ? score : -score;
+    return true;
+}
+
+bool Search::tablebaseMove(Board& board, const std::vector<Move>& moves, Move& bestMove, int& bestValue) const {
+    int bestScore = std::numeric_limits<int>::min();
+    for (const Move& move : moves) {
+        board.makeMove(move);
+        TablebaseResult result;
+        bool found = tablebases->probe(board, result);
+        board.unmakeMove(move);
+        if (!found) return false;
+
+        // The opponent's result, as a root score for printInfo at depth 1
+        int score = -result.wdl * (MATE_THRESHOLD - result.plies);
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+        }
+    }
+    bestValue = board.getTurn() == WHITE ? bestScore : -bestScore;
+    return true;
+}
+
+bool Search::probeTable(uint64_t key, int depth, int ply, int alpha, int beta, int& value, uint16_t& ttMove) {
+    TTEntry entry;
+    SEARCH_STAT(stats.ttProbes++);
+    if (tt->probe(key, entry)) {
+        SEARCH_STAT(stats.ttHits++);
+        ttMove = entry.move;
+        if (answersNode(entry, depth, alpha, beta)) {
+            SEARCH_STAT(stats.ttCutoffs++);
+            value = entry.score;
+            return true;
+        }
+    }
+
+    if (!analysisCache || ply > CACHE_MAX_PLY || depth < CACHE_MIN_DEPTH) return false;
+    SEARCH_STAT(stats.cacheProbes++);
+    if (!analysisCache->probe(key, entry)) return false;
+
+    SEARCH_STAT(stats.cacheHits++);
+    if (ttMove == 0) ttMove = entry.move;
+    if (answersNode(entry, depth, alpha, beta)) {
+        SEARCH_STAT(stats.cacheCutoffs++);
+        value = entry.score;
+        return true;
+    }
+    return false;
+}
+
+void Search::storeTable(uint64_t key, int depth, int ply, int alphaIn, int betaIn, int value, const Move& bestMove) {
+    TTBound bound = value <= alphaIn ? TT_UPPER : (value >= betaIn ? TT_LOWER : TT_EXACT);
+    tt->store(key, value, depth, bound, packMove(bestMove));
+    if (analysisCache && ply <= CACHE_MAX_PLY && depth >= CACHE_MIN_DEPTH) {
+        analysisCache->store(key, value, depth, bound, packMove(bestMove));
+    }
+}
+
+// --- Cooperative search ---
+//
+// The same search as findBestMove/alphaBeta, written as coroutines so a
+// SearchScheduler can suspend it every slice.nodesPerSlice nodes. Tracing is
+// not supported on this path.
+
+Task<Move> Search::findBestMoveCooperative(Board& board, int depth, SearchSlice& slice) {
+    nodesVisited = 0;
+    SEARCH_STAT(stats.clear());
+    getTranspositionTable();
+    limits = SearchLimits();
+    aborted = false;
+    slice.nextYield = slice.nodesPerSlice;
+    slice.timedOut = false;
+    slice.completedDepth = 0;
+    slice.score = 0;
+
+    std::vector<Move> moves = board.generateLegalMoves();
+    if (moves.empty()) co_return Move();
+
+    Move bestMove = moves[0];
+    bool maximizingPlayer = (board.getTurn() == WHITE);
+
+    for (int d = 1; d <= depth; ++d) {
+        int alpha = std::numeric_limits<int>::min();
+        int beta = std::numeric_limits<int>::max();
+        int bestValue = maximizingPlayer ? alpha : beta;
+        Move iterationBest;
+
         for (const auto& move : moves) {
+            if (nodesVisited >= slice.nextYield && co_await endSlice(slice, nodesVisited)) break;
             board.makeMove(move);
-            value = std::min(value, alphaBeta(board, depth - 1, alpha, beta, true));
+            int value = co_await alphaBetaCooperative(board, d - 1, 1, alpha, beta, !maximizingPlayer, slice);
             board.unmakeMove(move);
-            
-            beta = std::min(beta, value);
-            if (beta <= alpha) break; // Alpha cutoff
+            if (slice.timedOut) break;
+
+            if (maximizingPlayer ? value > bestValue : value < bestValue) {
+                bestValue = value;
+                iterationBest = move;
+            }
+            if (maximizingPlayer) alpha = std::max(alpha, bestValue);
+            else beta = std::min(beta, bestValue);
+        }
+        // An unfinished iteration is discarded
+        if (slice.timedOut) break;
+
+        bestMove = iterationBest;
+        slice.score = bestValue;
+        slice.completedDepth = d;
+        searchFirst(moves, packMove(bestMove));
+    }
+
+    co_return bestMove;
+}
+
+Task<int> Search::alphaBetaCooperative(Board& board, int depth, int ply, int alpha, int beta, bool maximizingPlayer, SearchSlice& slice) {
+    if (depth < COOPERATIVE_MIN_DEPTH) co_return alphaBeta(board, depth, ply, alpha, beta, maximizingPlayer);
+
+    if (nodesVisited >= slice.nextYield) co_await endSlice(slice, nodesVisited);
+    if (slice.timedOut) co_return 0;
+
+    nodesVisited++;
+    SEARCH_STAT(stats.nodes++);
+
+    uint64_t key = board.getHash();
+    uint16_t ttMove = 0;
+    int value;
+    if (probeTable(key, depth, ply, alpha, beta, value, ttMove)) co_return value;
+    if (tablebases && probeTablebase(board, depth, value)) co_return value;
+
+    std::vector<Move> moves = board.generateLegalMoves();
+    if (moves.empty()) co_return terminalValue(board, depth, maximizingPlayer);
+    if (ttMove != 0) searchFirst(moves, ttMove);
+
+    int alphaIn = alpha;
+    int betaIn = beta;
+    size_t bestIndex = 0;
+    value = maximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+
+    for (size_t i = 0; i < moves.size(); ++i) {
+        board.makeMove(moves[i]);
+        int score = co_await alphaBetaCooperative(board, depth - 1, ply + 1, alpha, beta, !maximizingPlayer, slice);
+        board.unmakeMove(moves[i]);
+        if (slice.timedOut) co_return 0;
+
+        if (maximizingPlayer ? score > value : score < value) {
+            value = score;
+            bestIndex = i;
+        }
+        if (maximizingPlayer) alpha = std::max(alpha, value);
+        else beta = std::min(beta, value);
+        if (alpha >= beta) {
+            SEARCH_STAT(stats.cutoffs++);
+            SEARCH_STAT(stats.firstMoveCutoffs += (i == 0));
+            break;
         }
-        return value;
     }
+
+    storeTable(key, depth, ply, alphaIn, betaIn, value, moves[bestIndex]);
+    co_return value;
 }
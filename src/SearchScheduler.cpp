@@ -0,0 +1,102 @@
+#include "SearchScheduler.h"
+
+struct SearchScheduler::Job {
+    Board board;
+    Search search;
+    SearchSlice slice;
+    Task<Move> task;
+    std::promise<ScheduledResult> promise;
+    std::chrono::steady_clock::time_point submitted;
+    int priority;
+    uint64_t sequence;
+};
+
+bool SearchScheduler::JobOrder::operator()(const Job* a, const Job* b) const {
+    // priority_queue pops the "largest": highest priority, then oldest sequence
+    if (a->priority != b->priority) return a->priority < b->priority;
+    return a->sequence > b->sequence;
+}
+
+SearchScheduler::SearchScheduler(int threads, std::shared_ptr<TranspositionTable> table, uint64_t nodesPerSlice)
+    : table(table ? std::move(table) : std::make_shared<TranspositionTable>()),
+      nodesPerSlice(nodesPerSlice > 0 ? nodesPerSlice : 1),
+      sequence(0),
+      unfinished(0),
+      stopping(false) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&SearchScheduler::workerLoop, this);
+    }
+}
+
+SearchScheduler::~SearchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+std::future<ScheduledResult> SearchScheduler::submit(const Board& board, const ScheduledSearch& options) {
+    auto job = std::make_unique<Job>();
+    job->board = board;
+    job->search.setTranspositionTable(table);
+    job->submitted = std::chrono::steady_clock::now();
+    job->slice.nodesPerSlice = nodesPerSlice;
+    if (options.timeLimit.count() > 0) job->slice.deadline = job->submitted + options.timeLimit;
+    job->priority = options.priority;
+    job->task = job->search.findBestMoveCooperative(job->board, options.depth, job->slice);
+    job->slice.resumePoint = job->task.start();
+    std::future<ScheduledResult> result = job->promise.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job->sequence = sequence++;
+        queue.push(job.release());
+        ++unfinished;
+    }
+    ready.notify_one();
+    return result;
+}
+
+void SearchScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready.wait(lock, [this] { return !queue.empty() || (stopping && unfinished == 0); });
+        if (queue.empty()) return; // Stopping and every search has finished
+
+        Job* job = queue.top();
+        queue.pop();
+        lock.unlock();
+
+        // Runs until the search yields or finishes
+        job->slice.resumePoint.resume();
+
+        if (job->task.done()) {
+            try {
+                ScheduledResult result;
+                result.bestMove = job->task.result();
+                result.score = job->slice.score;
+                result.depth = job->slice.completedDepth;
+                result.nodes = job->search.getNodesVisited();
+                result.timedOut = job->slice.timedOut;
+                result.milliseconds = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - job->submitted).count();
+                job->promise.set_value(result);
+            } catch (...) {
+                job->promise.set_exception(std::current_exception());
+            }
+            delete job;
+
+            lock.lock();
+            if (--unfinished == 0 && stopping) ready.notify_all();
+        } else {
+            lock.lock();
+            job->sequence = sequence++;
+            queue.push(job);
+            ready.notify_one();
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#include "SearchTrace.h"
+#include <cstring>
+
+bool SearchTracer::open(const std::string& filename, size_t capacity) {
+    close();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    TraceHeader header;
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.eventSize = sizeof(TraceEvent);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    buffer.assign(capacity > 0 ? capacity : 1, TraceEvent());
+    count = 0;
+    return true;
+}
+
+void SearchTracer::close() {
+    if (!file.is_open()) return;
+    flush();
+    file.close();
+}
+
+void SearchTracer::flush() {
+    if (count == 0 || !file.is_open()) return;
+    file.write(reinterpret_cast<const char*>(buffer.data()), count * sizeof(TraceEvent));
+    file.flush();
+    count = 0;
+}
+
+void SearchTracer::beginIteration(int depth, uint64_t node) {
+    TraceEvent& e = buffer[count];
+    std::memset(&e, 0, sizeof(e));
+    e.node = (uint32_t)node;
+    e.type = TRACE_ITERATION;
+    e.cutoffIndex = TRACE_NO_CUTOFF;
+    e.depth = (uint16_t)depth;
+    if (++count == buffer.size()) flush();
+}
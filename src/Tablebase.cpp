@@ -0,0 +1,863 @@
+#include "Tablebase.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+// Pieces in table order once arranged: white king, black king, then the
+// other white and black pieces, each side from queen down to pawn.
+// 'side' is 0 for White and 1 for Black.
+struct TablebasePosition {
+    struct Piece {
+        int type;
+        int side;
+        int square;
+    };
+    Piece pieces[4];
+    int count = 0;
+    int turn = 0;
+};
+
+namespace {
+
+using Position = TablebasePosition;
+
+constexpr uint64_t TB_MAGIC = 0x3142544e4154434fULL; // "OCTANTB1"
+constexpr uint32_t TB_VERSION = 2;
+constexpr int MAX_PIECES = 4;
+
+// Stored values. Wins are kept as (plies + 1) / 2 (always odd plies) and
+// losses as 0x80 | plies / 2 (always even), so 0x80 is checkmated.
+constexpr uint8_t TB_DRAW = 0;
+constexpr uint8_t TB_UNKNOWN = 0xFE; // Not decided yet, or no table
+constexpr uint8_t TB_ILLEGAL = 0xFF;
+constexpr int MAX_PLIES = 250;
+
+// Generation only: 'count' values above any move count
+constexpr uint8_t PROPAGATED = 253;   // Predecessors updated
+constexpr uint8_t PENDING_LOSS = 254; // Every move loses, result set later
+constexpr uint8_t CANNOT_LOSE = 255;  // Has a drawing or winning exit
+
+inline uint8_t winIn(int plies) { return (uint8_t)((plies + 1) / 2); }
+inline uint8_t lossIn(int plies) { return (uint8_t)(0x80 | (plies / 2)); }
+inline bool isWin(uint8_t v) { return v >= 1 && v < 0x80; }
+inline bool isLoss(uint8_t v) { return v >= 0x80 && v < TB_UNKNOWN; }
+inline int distance(uint8_t v) { return isWin(v) ? 2 * v - 1 : 2 * (v & 0x7F); }
+
+struct TableHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t pieces;
+    char name[8];
+    uint64_t entries;
+};
+
+struct Attacks {
+    uint64_t knight[64];
+    uint64_t king[64];
+    uint64_t pawn[2][64];    // Squares a pawn of each side attacks
+    uint64_t between[64][64];
+    uint8_t line[64][64];    // 1 = same rank or file, 2 = same diagonal
+
+    Attacks() {
+        std::memset(this, 0, sizeof(*this));
+        for (int square = 0; square < 64; ++square) {
+            int file = square % 8;
+            int rank = square / 8;
+            for (int df = -2; df <= 2; ++df) {
+                for (int dr = -2; dr <= 2; ++dr) {
+                    int f = file + df;
+                    int r = rank + dr;
+                    if (f < 0 || f > 7 || r < 0 || r > 7) continue;
+                    uint64_t bit = 1ULL << (r * 8 + f);
+                    if (std::abs(df * dr) == 2) knight[square] |= bit;
+                    if (std::abs(df) <= 1 && std::abs(dr) <= 1 && (df | dr) != 0) king[square] |= bit;
+                    if (std::abs(df) == 1 && dr == 1) pawn[0][square] |= bit;
+                    if (std::abs(df) == 1 && dr == -1) pawn[1][square] |= bit;
+                }
+            }
+            for (int df = -1; df <= 1; ++df) {
+                for (int dr = -1; dr <= 1; ++dr) {
+                    if ((df | dr) == 0) continue;
+                    uint64_t path = 0;
+                    for (int f = file + df, r = rank + dr; f >= 0 && f < 8 && r >= 0 && r < 8; f += df, r += dr) {
+                        int target = r * 8 + f;
+                        line[square][target] = (df == 0 || dr == 0) ? 1 : 2;
+                        between[square][target] = path;
+                        path |= 1ULL << target;
+                    }
+                }
+            }
+        }
+    }
+};
+
+const Attacks& attackTables() {
+    static const Attacks table;
+    return table;
+}
+
+const int TRIANGLE[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27}; // a1-d1-d4
+
+int triangleIndex(int square) {
+    for (int i = 0; i < 10; ++i) {
+        if (TRIANGLE[i] == square) return i;
+    }
+    return -1;
+}
+
+// Which pieces a table holds, in table order, and how positions are indexed:
+// side to move, then every piece's square, the white king's restricted to
+// the symmetry region and pawns' to ranks 2-7
+struct Layout {
+    int count = 0;
+    int types[MAX_PIECES];
+    int sides[MAX_PIECES];
+    int radix[MAX_PIECES];
+    bool pawns = false;
+    uint64_t size = 0;
+};
+
+// Non-king pieces of each side from a name such as "KQKR". Returns false if
+// the name is not a material with two kings and at most four pieces.
+bool parseMaterial(const std::string& name, std::vector<int> sides[2]) {
+    static const std::string letters = "PNBRQ";
+    if (name.size() < 2 || name.size() > MAX_PIECES || name[0] != 'K') return false;
+    int side = 0;
+    for (size_t i = 1; i < name.size(); ++i) {
+        if (name[i] == 'K') {
+            if (++side > 1) return false;
+            continue;
+        }
+        size_t type = letters.find(name[i]);
+        if (type == std::string::npos) return false;
+        sides[side].push_back((int)type + PAWN);
+    }
+    return side == 1;
+}
+
+// Whether a side with pieces 'a' is the one tables put as White against 'b'
+bool stronger(const std::vector<int>& a, const std::vector<int>& b) {
+    if (a.size() != b.size()) return a.size() > b.size();
+    return std::lexicographical_compare(b.begin(), b.end(), a.begin(), a.end());
+}
+
+// Table name for the material, stronger side first
+std::string materialName(std::vector<int> white, std::vector<int> black) {
+    static const char letters[] = " PNBRQ";
+    std::sort(white.rbegin(), white.rend());
+    std::sort(black.rbegin(), black.rend());
+    if (stronger(black, white)) std::swap(white, black);
+    std::string name = "K";
+    for (int type : white) name += letters[type];
+    name += 'K';
+    for (int type : black) name += letters[type];
+    return name;
+}
+
+int pawnCount(const std::string& name) {
+    return (int)std::count(name.begin(), name.end(), 'P');
+}
+
+// Tables reached by a capture or a promotion
+std::vector<std::string> subtables(const std::string& name) {
+    std::vector<int> sides[2];
+    parseMaterial(name, sides);
+    std::vector<std::string> result;
+    for (int side = 0; side < 2; ++side) {
+        for (size_t i = 0; i < sides[side].size(); ++i) {
+            std::vector<int> changed[2] = {sides[0], sides[1]};
+            changed[side].erase(changed[side].begin() + i);
+            if (changed[0].size() + changed[1].size() > 0) result.push_back(materialName(changed[0], changed[1]));
+            if (sides[side][i] != PAWN) continue;
+            for (int promotion = KNIGHT; promotion <= QUEEN; ++promotion) {
+                std::vector<int> promoted[2] = {sides[0], sides[1]};
+                promoted[side][i] = promotion;
+                result.push_back(materialName(promoted[0], promoted[1]));
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+Layout makeLayout(const std::string& name) {
+    std::vector<int> sides[2];
+    parseMaterial(name, sides);
+    Layout layout;
+    layout.types[0] = layout.types[1] = KING;
+    layout.sides[0] = 0;
+    layout.sides[1] = 1;
+    layout.count = 2;
+    for (int side = 0; side < 2; ++side) {
+        for (int type : sides[side]) {
+            layout.types[layout.count] = type;
+            layout.sides[layout.count++] = side;
+            if (type == PAWN) layout.pawns = true;
+        }
+    }
+    layout.size = 2;
+    for (int slot = 0; slot < layout.count; ++slot) {
+        if (slot == 0) layout.radix[slot] = layout.pawns ? 32 : 10;
+        else layout.radix[slot] = layout.types[slot] == PAWN ? 48 : 64;
+        layout.size *= (uint64_t)layout.radix[slot];
+    }
+    return layout;
+}
+
+// Counts of each piece per side, one nibble each
+uint64_t signature(const Position& p) {
+    uint64_t key = 0;
+    for (int i = 0; i < p.count; ++i) key += 1ULL << (4 * (p.pieces[i].side * 6 + p.pieces[i].type - 1));
+    return key;
+}
+
+uint64_t signature(const Layout& layout) {
+    uint64_t key = 0;
+    for (int i = 0; i < layout.count; ++i) key += 1ULL << (4 * (layout.sides[i] * 6 + layout.types[i] - 1));
+    return key;
+}
+
+// Puts the stronger side as White and the pieces in table order
+void arrange(Position& p) {
+    std::vector<int> sides[2];
+    for (int i = 0; i < p.count; ++i) {
+        if (p.pieces[i].type != KING) sides[p.pieces[i].side].push_back(p.pieces[i].type);
+    }
+    std::sort(sides[0].rbegin(), sides[0].rend());
+    std::sort(sides[1].rbegin(), sides[1].rend());
+    if (stronger(sides[1], sides[0])) {
+        for (int i = 0; i < p.count; ++i) {
+            p.pieces[i].side ^= 1;
+            p.pieces[i].square ^= 56;
+        }
+        p.turn ^= 1;
+    }
+    auto order = [](const Position::Piece& piece) {
+        return piece.type == KING ? piece.side : 2 + piece.side * 8 + (KING - piece.type);
+    };
+    // Insertion sort over at most four pieces
+    for (int i = 1; i < p.count && i < MAX_PIECES; ++i) {
+        Position::Piece piece = p.pieces[i];
+        int j = i;
+        for (; j > 0 && order(piece) < order(p.pieces[j - 1]); --j) p.pieces[j] = p.pieces[j - 1];
+        p.pieces[j] = piece;
+    }
+}
+
+inline int transpose(int square) { return ((square & 7) << 3) | (square >> 3); }
+
+uint64_t rawIndex(const Layout& layout, const int* squares, int turn) {
+    int sorted[MAX_PIECES];
+    std::copy(squares, squares + layout.count, sorted);
+    // Two pieces of the same kind in ascending order of squares
+    if (layout.count == 4 && layout.types[2] == layout.types[3] && layout.sides[2] == layout.sides[3] &&
+        sorted[3] < sorted[2]) {
+        std::swap(sorted[2], sorted[3]);
+    }
+    uint64_t index = 0;
+    for (int slot = layout.count - 1; slot >= 0; --slot) {
+        int code;
+        if (slot == 0) code = layout.pawns ? (sorted[0] >> 3) * 4 + (sorted[0] & 7) : triangleIndex(sorted[0]);
+        else code = layout.types[slot] == PAWN ? sorted[slot] - 8 : sorted[slot];
+        index = index * (uint64_t)layout.radix[slot] + (uint64_t)code;
+    }
+    return index * 2 + (uint64_t)turn;
+}
+
+// Squares of an arranged position with the white king moved into the
+// symmetry region. With the king on the a1-h8 diagonal the position can
+// still be mirrored along it: 'mirrored' gets those squares.
+bool symmetryRegion(const Layout& layout, const Position& p, int* squares, int* mirrored) {
+    int wk = p.pieces[0].square;
+    int flip = ((wk & 7) > 3 ? 7 : 0) | (!layout.pawns && (wk >> 3) > 3 ? 56 : 0);
+    for (int i = 0; i < layout.count; ++i) squares[i] = p.pieces[i].square ^ flip;
+    if (layout.pawns) return false;
+    if ((squares[0] >> 3) > (squares[0] & 7)) {
+        for (int i = 0; i < layout.count; ++i) squares[i] = transpose(squares[i]);
+    }
+    if ((squares[0] >> 3) != (squares[0] & 7)) return false;
+    for (int i = 0; i < layout.count; ++i) mirrored[i] = transpose(squares[i]);
+    return true;
+}
+
+// Index of an arranged position. Every position has exactly one: the
+// smallest of its symmetric images.
+uint64_t indexOf(const Layout& layout, const Position& p) {
+    int squares[MAX_PIECES];
+    int mirrored[MAX_PIECES];
+    if (symmetryRegion(layout, p, squares, mirrored)) {
+        return std::min(rawIndex(layout, squares, p.turn), rawIndex(layout, mirrored, p.turn));
+    }
+    return rawIndex(layout, squares, p.turn);
+}
+
+void decode(const Layout& layout, uint64_t index, Position& p) {
+    p.count = layout.count;
+    p.turn = (int)(index & 1);
+    index >>= 1;
+    for (int slot = 0; slot < layout.count; ++slot) {
+        int code = (int)(index % (uint64_t)layout.radix[slot]);
+        index /= (uint64_t)layout.radix[slot];
+        int square;
+        if (slot == 0) square = layout.pawns ? (code / 4) * 8 + code % 4 : TRIANGLE[code];
+        else square = layout.types[slot] == PAWN ? code + 8 : code;
+        p.pieces[slot] = {layout.types[slot], layout.sides[slot], square};
+    }
+}
+
+uint64_t occupancy(const Position& p) {
+    uint64_t occupied = 0;
+    for (int i = 0; i < p.count; ++i) occupied |= 1ULL << p.pieces[i].square;
+    return occupied;
+}
+
+bool attacks(const Position::Piece& piece, int target, uint64_t occupied) {
+    const Attacks& a = attackTables();
+    int from = piece.square;
+    switch (piece.type) {
+    case PAWN: return (a.pawn[piece.side][from] >> target) & 1;
+    case KNIGHT: return (a.knight[from] >> target) & 1;
+    case KING: return (a.king[from] >> target) & 1;
+    case BISHOP: return a.line[from][target] == 2 && (a.between[from][target] & occupied) == 0;
+    case ROOK: return a.line[from][target] == 1 && (a.between[from][target] & occupied) == 0;
+    case QUEEN: return a.line[from][target] != 0 && (a.between[from][target] & occupied) == 0;
+    }
+    return false;
+}
+
+bool inCheck(const Position& p, int side) {
+    int king = -1;
+    for (int i = 0; i < p.count; ++i) {
+        if (p.pieces[i].type == KING && p.pieces[i].side == side) king = p.pieces[i].square;
+    }
+    uint64_t occupied = occupancy(p);
+    for (int i = 0; i < p.count; ++i) {
+        if (p.pieces[i].side != side && attacks(p.pieces[i], king, occupied)) return true;
+    }
+    return false;
+}
+
+struct TableMove {
+    int piece;
+    int to;
+    int captured;  // Index of the captured piece, or -1
+    int promotion; // Piece type, or 0
+};
+
+constexpr int MAX_MOVES = 128;
+
+// Pseudo-legal moves of the side to move
+int generateMoves(const Position& p, TableMove* moves) {
+    const Attacks& a = attackTables();
+    uint64_t occupied = occupancy(p);
+    int pieceAt[64];
+    std::fill(std::begin(pieceAt), std::end(pieceAt), -1);
+    uint64_t own = 0;
+    for (int i = 0; i < p.count; ++i) {
+        pieceAt[p.pieces[i].square] = i;
+        if (p.pieces[i].side == p.turn) own |= 1ULL << p.pieces[i].square;
+    }
+
+    int n = 0;
+    auto add = [&](int piece, int to, int promotion) {
+        int captured = pieceAt[to];
+        moves[n++] = {piece, to, captured, promotion};
+    };
+    for (int i = 0; i < p.count; ++i) {
+        const Position::Piece& piece = p.pieces[i];
+        if (piece.side != p.turn) continue;
+        int from = piece.square;
+
+        if (piece.type == PAWN) {
+            int forward = piece.side == 0 ? 8 : -8;
+            bool promotes = piece.side == 0 ? from >= 48 : from < 16;
+            uint64_t targets = a.pawn[piece.side][from] & occupied & ~own;
+            int push = from + forward;
+            if (!((occupied >> push) & 1)) targets |= 1ULL << push;
+            int start = piece.side == 0 ? 1 : 6;
+            if (from / 8 == start && !((occupied >> push) & 1) && !((occupied >> (push + forward)) & 1)) {
+                targets |= 1ULL << (push + forward);
+            }
+            for (; targets != 0; targets &= targets - 1) {
+                int to = __builtin_ctzll(targets);
+                if (!promotes) {
+                    add(i, to, 0);
+                    continue;
+                }
+                for (int promotion = QUEEN; promotion >= KNIGHT; --promotion) add(i, to, promotion);
+            }
+            continue;
+        }
+
+        uint64_t targets = 0;
+        if (piece.type == KNIGHT) targets = a.knight[from];
+        else if (piece.type == KING) targets = a.king[from];
+        else {
+            for (int to = 0; to < 64; ++to) {
+                if (attacks(piece, to, occupied)) targets |= 1ULL << to;
+            }
+        }
+        for (targets &= ~own; targets != 0; targets &= targets - 1) add(i, __builtin_ctzll(targets), 0);
+    }
+    return n;
+}
+
+Position applyMove(const Position& p, const TableMove& move) {
+    Position next = p;
+    next.pieces[move.piece].square = move.to;
+    if (move.promotion != 0) next.pieces[move.piece].type = move.promotion;
+    if (move.captured >= 0) {
+        std::copy(next.pieces + move.captured + 1, next.pieces + next.count, next.pieces + move.captured);
+        --next.count;
+    }
+    next.turn ^= 1;
+    return next;
+}
+
+// Whether a pawn of 'side' that has just double-pushed to 'square' can be
+// taken en passant: an enemy pawn stands beside it
+bool enPassantTarget(const Position& p, int square, int side) {
+    for (int i = 0; i < p.count; ++i) {
+        const Position::Piece& piece = p.pieces[i];
+        if (piece.type == PAWN && piece.side != side && piece.square / 8 == square / 8 &&
+            std::abs(piece.square - square) == 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether 'move' is a double pawn push the opponent can answer en passant.
+// Tables hold no en passant square, so such pushes are scored like moves
+// out of the table.
+bool allowsEnPassant(const Position& p, const TableMove& move) {
+    const Position::Piece& piece = p.pieces[move.piece];
+    return piece.type == PAWN && std::abs(move.to - piece.square) == 16 && enPassantTarget(p, move.to, piece.side);
+}
+
+// Calls 'visit' with every legal position that reaches 'p' by a move that
+// neither captures nor promotes, nor is a double push allowing en passant
+template <typename Visit>
+void forEachUnmove(const Position& p, Visit visit) {
+    const Attacks& a = attackTables();
+    uint64_t occupied = occupancy(p);
+    int mover = p.turn ^ 1;
+    for (int i = 0; i < p.count; ++i) {
+        const Position::Piece& piece = p.pieces[i];
+        if (piece.side != mover) continue;
+        int to = piece.square;
+
+        uint64_t origins = 0;
+        if (piece.type == PAWN) {
+            int back = mover == 0 ? -8 : 8;
+            int from = to + back;
+            if (from >= 8 && from < 56 && !((occupied >> from) & 1)) {
+                origins |= 1ULL << from;
+                int doubleRank = mover == 0 ? 3 : 4;
+                if (to / 8 == doubleRank && !((occupied >> (from + back)) & 1) && !enPassantTarget(p, to, mover)) {
+                    origins |= 1ULL << (from + back);
+                }
+            }
+        } else if (piece.type == KNIGHT) {
+            origins = a.knight[to] & ~occupied;
+        } else if (piece.type == KING) {
+            origins = a.king[to] & ~occupied;
+        } else {
+            for (int from = 0; from < 64; ++from) {
+                if (!((occupied >> from) & 1) && attacks(piece, from, occupied)) origins |= 1ULL << from;
+            }
+        }
+
+        for (; origins != 0; origins &= origins - 1) {
+            Position previous = p;
+            previous.pieces[i].square = __builtin_ctzll(origins);
+            previous.turn = mover;
+            if (!inCheck(previous, p.turn)) visit(previous);
+        }
+    }
+}
+
+// Whether 'p' is its own mirror image along a1-h8: its moves then reach
+// some positions twice, which the move counts do not see
+bool symmetric(const Layout& layout, const Position& p) {
+    int squares[MAX_PIECES];
+    int mirrored[MAX_PIECES];
+    return symmetryRegion(layout, p, squares, mirrored) &&
+           rawIndex(layout, squares, p.turn) == rawIndex(layout, mirrored, p.turn);
+}
+
+} // namespace
+
+struct Tablebases::Table {
+    Layout layout;
+    MappedFile file;
+    const uint8_t* data = nullptr;
+};
+
+Tablebases::Tablebases() {}
+
+Tablebases::~Tablebases() {}
+
+bool Tablebases::load(const std::string& filename) {
+    auto table = std::make_unique<Table>();
+    if (!table->file.open(filename) || table->file.size() < sizeof(TableHeader)) return false;
+    TableHeader header;
+    std::memcpy(&header, table->file.data(), sizeof(header));
+    std::string name(header.name, strnlen(header.name, sizeof(header.name)));
+    std::vector<int> sides[2];
+    if (header.magic != TB_MAGIC || header.version != TB_VERSION || !parseMaterial(name, sides)) return false;
+    table->layout = makeLayout(name);
+    if (header.entries != table->layout.size || table->file.size() != sizeof(TableHeader) + header.entries) return false;
+    table->data = reinterpret_cast<const uint8_t*>(table->file.data()) + sizeof(TableHeader);
+    uint64_t key = signature(table->layout);
+    tables[key] = std::move(table);
+    return true;
+}
+
+bool Tablebases::open(const std::string& directory) {
+    tables.clear();
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".otb") load(entry.path().string());
+    }
+    return !tables.empty();
+}
+
+uint8_t Tablebases::probeValue(Position p) const {
+    if (p.count == 2) return TB_DRAW;
+    arrange(p);
+    auto it = tables.find(signature(p));
+    if (it == tables.end()) return TB_UNKNOWN;
+    return it->second->data[indexOf(it->second->layout, p)];
+}
+
+bool Tablebases::probe(const Board& board, TablebaseResult& result) const {
+    if (board.getCastlingRights() != 0 || board.getEnPassantSquare() >= 0) return false;
+    Position p;
+    for (int square = 0; square < 64; ++square) {
+        int piece = board.getPieceAt(square);
+        if (piece == EMPTY) continue;
+        if (p.count == MAX_PIECES) return false;
+        p.pieces[p.count++] = {piece & 0x7, (piece & 0x18) == BLACK ? 1 : 0, square};
+    }
+    p.turn = board.getTurn() == BLACK ? 1 : 0;
+
+    uint8_t value = probeValue(p);
+    if (value >= TB_UNKNOWN) return false;
+    result.wdl = isWin(value) ? 1 : (isLoss(value) ? -1 : 0);
+    result.plies = value == TB_DRAW ? 0 : distance(value);
+    return true;
+}
+
+std::vector<std::string> Tablebases::allTables() {
+    static const char letters[] = "QRBNP";
+    std::vector<std::string> names;
+    for (int i = 0; i < 5; ++i) {
+        names.push_back(std::string("K") + letters[i] + "K");
+        for (int j = i; j < 5; ++j) {
+            names.push_back(std::string("K") + letters[i] + letters[j] + "K");
+            names.push_back(std::string("K") + letters[i] + "K" + letters[j]);
+        }
+    }
+    // Captures lead to fewer pieces, promotions to fewer pawns
+    std::stable_sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) {
+        if (a.size() != b.size()) return a.size() < b.size();
+        return pawnCount(a) < pawnCount(b);
+    });
+    return names;
+}
+
+bool Tablebases::generate(const std::string& directory, const std::vector<std::string>& names, int threads,
+                          std::ostream& log) {
+    std::vector<std::string> wanted;
+    for (const std::string& name : names) {
+        std::vector<int> sides[2];
+        if (!parseMaterial(name, sides) || sides[0].size() + sides[1].size() == 0) {
+            log << "Invalid table " << name << " (expected a material such as KRK or KQKP)" << std::endl;
+            return false;
+        }
+        wanted.push_back(materialName(sides[0], sides[1]));
+    }
+    // Everything the requested tables lead to
+    for (size_t i = 0; i < wanted.size(); ++i) {
+        for (const std::string& sub : subtables(wanted[i])) {
+            if (std::find(wanted.begin(), wanted.end(), sub) == wanted.end()) wanted.push_back(sub);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+
+    Tablebases tablebases;
+    for (const std::string& name : allTables()) {
+        if (!names.empty() && std::find(wanted.begin(), wanted.end(), name) == wanted.end()) continue;
+        std::string filename = (std::filesystem::path(directory) / (name + ".otb")).string();
+        if (tablebases.load(filename)) {
+            log << name << ": using existing " << filename << std::endl;
+            continue;
+        }
+        if (!tablebases.generateTable(name, filename, threads, log)) return false;
+    }
+    return true;
+}
+
+bool Tablebases::generateTable(const std::string& name, const std::string& filename, int threads, std::ostream& log) {
+    auto start = std::chrono::steady_clock::now();
+    const Layout layout = makeLayout(name);
+    const uint64_t size = layout.size;
+    std::vector<uint8_t> result;
+    std::vector<uint8_t> count;
+    std::vector<std::vector<uint32_t>> buckets;
+
+    // Value of a move leaving the table, from the mover's point of view:
+    // win or loss in plies (positive or negative), or draw (0)
+    auto exitValue = [&](const Position& next) {
+        uint8_t value = probeValue(next);
+        if (isLoss(value)) return distance(value) + 1;
+        if (isWin(value)) return -(distance(value) + 1);
+        return 0;
+    };
+
+    // A double push allowing en passant leads to the stored position plus
+    // the en passant captures. The stored position's value comes from the
+    // previous pass: pawns never move back, so every pass settles the
+    // positions one more such push away from the end, and the passes stop
+    // once the table no longer changes.
+    std::vector<uint8_t> previous;
+    auto pushValue = [&](const Position& p, const TableMove& move, const Position& next) {
+        auto preference = [](int value) { return value > 0 ? 1000 - value : (value < 0 ? -1000 - value : 0); };
+        uint8_t stored = previous.empty() ? TB_DRAW : previous[indexOf(layout, next)];
+        int value = isLoss(stored) ? distance(stored) + 1 : (isWin(stored) ? -(distance(stored) + 1) : 0);
+        int pushed = -1;
+        for (int i = 0; i < next.count; ++i) {
+            if (next.pieces[i].square == move.to) pushed = i;
+        }
+        int passed = (p.pieces[move.piece].square + move.to) / 2;
+        for (int i = 0; i < next.count; ++i) {
+            const Position::Piece& piece = next.pieces[i];
+            if (piece.type != PAWN || piece.side != next.turn || piece.square / 8 != move.to / 8 ||
+                std::abs(piece.square - move.to) != 1) {
+                continue;
+            }
+            Position captured = applyMove(next, {i, passed, pushed, 0});
+            if (inCheck(captured, next.turn)) continue;
+            int reply = exitValue(captured); // For the side capturing
+            int mover = reply > 0 ? -(reply + 1) : (reply < 0 ? 1 - reply : 0);
+            if (preference(mover) < preference(value)) value = mover;
+        }
+        return value;
+    };
+
+    // Every move loses: returns the plies to mate with the longest defence,
+    // or -1 if some move does not (yet) lose
+    auto lossDistance = [&](const Position& p) {
+        TableMove moves[MAX_MOVES];
+        int n = generateMoves(p, moves);
+        int longest = -1;
+        for (int i = 0; i < n; ++i) {
+            Position next = applyMove(p, moves[i]);
+            if (inCheck(next, p.turn)) continue;
+            int plies;
+            if (moves[i].captured >= 0 || moves[i].promotion != 0) {
+                plies = -exitValue(next);
+            } else if (allowsEnPassant(p, moves[i])) {
+                plies = -pushValue(p, moves[i], next);
+            } else {
+                uint8_t value = result[indexOf(layout, next)];
+                plies = isWin(value) ? distance(value) + 1 : -1;
+            }
+            if (plies <= 0) return -1;
+            longest = std::max(longest, plies);
+        }
+        return longest;
+    };
+
+    // Scores mates, stalemates and moves out of the table, and counts the
+    // moves staying in it
+    std::atomic<uint64_t> nextChunk(0);
+    std::mutex bucketMutex;
+    auto initialize = [&]() {
+        constexpr uint64_t CHUNK = 4096;
+        std::vector<std::pair<int, uint32_t>> pending;
+        TableMove moves[MAX_MOVES];
+        for (uint64_t begin; (begin = nextChunk.fetch_add(CHUNK)) < size;) {
+            for (uint64_t index = begin; index < std::min(begin + CHUNK, size); ++index) {
+                Position p;
+                decode(layout, index, p);
+                uint64_t occupied = occupancy(p);
+                // Other images of a position are never probed
+                if (__builtin_popcountll(occupied) != p.count || indexOf(layout, p) != index ||
+                    inCheck(p, p.turn ^ 1)) {
+                    result[index] = TB_ILLEGAL;
+                    continue;
+                }
+
+                int n = generateMoves(p, moves);
+                int legal = 0;
+                int internal = 0;
+                int fastestWin = 0;
+                int slowestLoss = 0;
+                bool draws = false;
+                for (int i = 0; i < n; ++i) {
+                    Position next = applyMove(p, moves[i]);
+                    if (inCheck(next, p.turn)) continue;
+                    ++legal;
+                    int value;
+                    if (moves[i].captured >= 0 || moves[i].promotion != 0) {
+                        value = exitValue(next);
+                    } else if (allowsEnPassant(p, moves[i])) {
+                        value = pushValue(p, moves[i], next);
+                    } else {
+                        ++internal;
+                        continue;
+                    }
+                    if (value > 0) fastestWin = fastestWin == 0 ? value : std::min(fastestWin, value);
+                    else if (value < 0) slowestLoss = std::max(slowestLoss, -value);
+                    else draws = true;
+                }
+
+                if (legal == 0) {
+                    if (inCheck(p, p.turn)) {
+                        result[index] = lossIn(0);
+                        pending.push_back({0, (uint32_t)index});
+                    } else {
+                        result[index] = TB_DRAW;
+                    }
+                } else if (fastestWin > 0) {
+                    count[index] = CANNOT_LOSE;
+                    pending.push_back({fastestWin, (uint32_t)index});
+                } else if (draws) {
+                    count[index] = CANNOT_LOSE;
+                    if (internal == 0) result[index] = TB_DRAW;
+                } else if (internal == 0) {
+                    count[index] = PENDING_LOSS;
+                    pending.push_back({slowestLoss, (uint32_t)index});
+                } else {
+                    count[index] = symmetric(layout, p) ? 1 : (uint8_t)internal;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(bucketMutex);
+        for (const auto& [plies, index] : pending) buckets[plies].push_back(index);
+    };
+
+    // En passant needs a pawn on each side; each pawn double-pushes at most once
+    std::vector<int> sides[2];
+    parseMaterial(name, sides);
+    bool enPassant = std::count(sides[0].begin(), sides[0].end(), PAWN) > 0 &&
+                     std::count(sides[1].begin(), sides[1].end(), PAWN) > 0;
+    int passes = enPassant ? pawnCount(name) + 2 : 1;
+
+    int longest = 0;
+    int passesRun = 0;
+    auto initialized = start;
+    for (int pass = 0; pass < passes; ++pass) {
+        ++passesRun;
+        result.assign(size, TB_UNKNOWN);
+        count.assign(size, 0);
+        buckets.assign(MAX_PLIES + 2, {});
+        nextChunk = 0;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) workers.emplace_back(initialize);
+        for (auto& w : workers) w.join();
+        if (pass == 0) initialized = std::chrono::steady_clock::now();
+
+        // Retrograde passes in order of distance to mate: the predecessors of a
+        // loss in d plies win in d + 1; a predecessor of a win loses once all
+        // its moves are known to lose
+        longest = 0;
+        for (int plies = 0; plies <= MAX_PLIES; ++plies) {
+            std::vector<uint32_t>& bucket = buckets[plies];
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                uint32_t index = bucket[i];
+                uint8_t& value = result[index];
+                if (value == TB_UNKNOWN) value = plies % 2 ? winIn(plies) : lossIn(plies);
+                if (value == TB_DRAW || distance(value) != plies || count[index] == PROPAGATED) continue;
+                count[index] = PROPAGATED;
+                longest = plies;
+
+                Position p;
+                decode(layout, index, p);
+                bool lost = isLoss(value);
+                forEachUnmove(p, [&](const Position& previousPosition) {
+                    uint64_t previousIndex = indexOf(layout, previousPosition);
+                    if (result[previousIndex] != TB_UNKNOWN) return;
+                    if (lost) {
+                        result[previousIndex] = winIn(plies + 1);
+                        buckets[plies + 1].push_back((uint32_t)previousIndex);
+                        return;
+                    }
+                    uint8_t& moves = count[previousIndex];
+                    if (moves >= PROPAGATED) return;
+                    if (moves > 1) {
+                        --moves;
+                        return;
+                    }
+                    int loss = lossDistance(previousPosition);
+                    if (loss < 0) return;
+                    if (loss > MAX_PLIES) {
+                        log << name << ": mate too long to store" << std::endl;
+                        return;
+                    }
+                    moves = PENDING_LOSS;
+                    buckets[loss].push_back((uint32_t)previousIndex);
+                });
+            }
+            std::vector<uint32_t>().swap(bucket);
+        }
+        for (uint8_t& value : result) {
+            if (value == TB_UNKNOWN) value = TB_DRAW;
+        }
+        if (result == previous) break;
+        if (pass + 1 < passes) previous = result;
+    }
+
+    uint64_t wins = 0;
+    uint64_t draws = 0;
+    uint64_t losses = 0;
+    for (uint8_t value : result) {
+        wins += isWin(value);
+        losses += isLoss(value);
+        draws += value == TB_DRAW;
+    }
+
+    TableHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = TB_MAGIC;
+    header.version = TB_VERSION;
+    header.pieces = (uint32_t)layout.count;
+    std::memcpy(header.name, name.data(), name.size());
+    header.entries = size;
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(result.data()), (std::streamsize)size);
+        if (!file) {
+            log << "Cannot write " << filename << std::endl;
+            return false;
+        }
+    }
+    if (!load(filename)) {
+        log << "Cannot map " << filename << std::endl;
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    log << name << ": " << size << " positions, " << wins << " wins " << draws << " draws " << losses
+        << " losses, longest mate " << longest << " plies, " << std::fixed << std::setprecision(1)
+        << std::chrono::duration<double>(now - start).count() << "s (scoring "
+        << std::chrono::duration<double>(initialized - start).count() << "s on " << threads << " threads";
+    if (enPassant) log << ", " << passesRun << " passes for en passant";
+    log << ")" << std::endl;
+    return true;
+}
@@ -0,0 +1,60 @@
+#include "Task.h"
+#include <new>
+
+namespace {
+
+constexpr size_t GRANULE = 64;
+constexpr size_t SIZE_CLASSES = 32; // Frames up to 2 KB are pooled
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Blocks freed on a thread go to that thread's lists, wherever they were
+// allocated; a search that migrates between scheduler threads is fine.
+struct FreeLists {
+    FreeBlock* heads[SIZE_CLASSES] = {};
+
+    ~FreeLists() {
+        for (FreeBlock*& head : heads) {
+            while (head) {
+                FreeBlock* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+};
+
+thread_local FreeLists freeLists;
+
+inline size_t sizeClass(size_t size) {
+    return (size + GRANULE - 1) / GRANULE - 1;
+}
+
+} // namespace
+
+void* FramePool::allocate(size_t size) {
+    size_t index = sizeClass(size);
+    if (index >= SIZE_CLASSES) return ::operator new(size);
+
+    FreeBlock*& head = freeLists.heads[index];
+    if (head) {
+        FreeBlock* block = head;
+        head = block->next;
+        return block;
+    }
+    return ::operator new((index + 1) * GRANULE);
+}
+
+void FramePool::deallocate(void* ptr, size_t size) {
+    size_t index = sizeClass(size);
+    if (index >= SIZE_CLASSES) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = freeLists.heads[index];
+    freeLists.heads[index] = block;
+}
@@ -0,0 +1,80 @@
+#include "TranspositionTable.h"
+
+namespace {
+
+// Data layout: score (32 bits) | depth (8) | bound (2) | move (16)
+inline uint64_t packEntry(int score, int depth, TTBound bound, uint16_t move) {
+    return (uint64_t)(uint32_t)score
+         | ((uint64_t)(uint8_t)depth << 32)
+         | ((uint64_t)bound << 40)
+         | ((uint64_t)move << 42);
+}
+
+inline TTEntry unpackEntry(uint64_t data) {
+    TTEntry entry;
+    entry.score = (int32_t)(uint32_t)data;
+    entry.depth = (int)(uint8_t)(data >> 32);
+    entry.bound = (TTBound)((data >> 40) & 0x3);
+    entry.move = (uint16_t)(data >> 42);
+    return entry;
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes) : bucketMask(0), sizeMB(0) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    if (megabytes == 0) megabytes = 1;
+
+    // Round down to a power of two so the index is a mask
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) count *= 2;
+
+    buckets.reset(new Bucket[count]);
+    bucketMask = count - 1;
+    sizeMB = megabytes;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i <= bucketMask; ++i) {
+        for (Slot& slot : buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const Bucket& bucket = buckets[key & bucketMask];
+    for (const Slot& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data != 0) {
+            entry = unpackEntry(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int score, int depth, TTBound bound, uint16_t move) {
+    Bucket& bucket = buckets[key & bucketMask];
+    uint64_t data = packEntry(score, depth, bound, move);
+
+    // Depth-preferred slot: replace if shallower or the same position
+    Slot& deep = bucket.slots[0];
+    uint64_t deepData = deep.data.load(std::memory_order_relaxed);
+    uint64_t deepKey = deep.check.load(std::memory_order_relaxed) ^ deepData;
+    if (deepData == 0 || deepKey == key || unpackEntry(deepData).depth <= depth) {
+        deep.check.store(key ^ data, std::memory_order_relaxed);
+        deep.data.store(data, std::memory_order_relaxed);
+        return;
+    }
+
+    Slot& recent = bucket.slots[1];
+    recent.check.store(key ^ data, std::memory_order_relaxed);
+    recent.data.store(data, std::memory_order_relaxed);
+}
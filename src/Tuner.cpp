@@ -0,0 +1,328 @@
+#include "Tuner.h"
+#include "DataGen.h"
+#include "EPDSuite.h"
+#include "EvalTables.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+struct Tuner::Dataset {
+    MappedFile file;
+    std::vector<PackedPosition> owned; // Records parsed from EPD
+    bool scored = true;                // EPD records have no search score
+    const PackedPosition* records = nullptr;
+    size_t count = 0;
+};
+
+namespace {
+
+// Weights: a square table entry per piece type and square, then the material
+// values of pawn to queen (the king's cancels out)
+constexpr int TABLE_WEIGHTS = 6 * 64;
+constexpr int WEIGHT_COUNT = TABLE_WEIGHTS + 5;
+
+// Positions decoded at a time, so the sigmoid and loss loop runs over plain
+// arrays. It stays scalar: std::exp is a libm call without -ffast-math.
+constexpr int BLOCK = 256;
+
+inline int tableWeight(int type, int square) {
+    return (type - 1) * 64 + square;
+}
+
+inline int materialWeight(int type) {
+    return TABLE_WEIGHTS + type - 1;
+}
+
+// Active weights of one position: index and +1 (White) or -1 (Black)
+struct Features {
+    int count = 0;
+    uint16_t index[64];
+    int8_t sign[64];
+};
+
+inline void decode(const PackedPosition& p, Features& f) {
+    f.count = 0;
+    uint64_t bits = p.occupancy;
+    for (int n = 0; bits != 0 && n < 32; ++n) {
+        int square = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        int nibble = (p.pieces[n / 2] >> (4 * (n % 2))) & 0xF;
+        int type = nibble & 0x7;
+        if (type == EMPTY || type > KING) continue;
+        int8_t sign = (nibble & 8) ? -1 : 1;
+        f.index[f.count] = (uint16_t)tableWeight(type, (nibble & 8) ? square ^ 56 : square);
+        f.sign[f.count++] = sign;
+        if (type != KING) {
+            f.index[f.count] = (uint16_t)materialWeight(type);
+            f.sign[f.count++] = sign;
+        }
+    }
+}
+
+struct Span {
+    const PackedPosition* records;
+    size_t count;
+};
+
+struct Pass {
+    double loss = 0;
+    std::vector<double> gradient; // Sum of error * sigmoid' per weight
+};
+
+// Sum of squared errors over 'span' and, with 'withGradient', the gradient
+// of it without the constant factors
+void evaluateSpan(const Span& span, const float* weights, double lambda, double scale, bool withGradient, Pass& pass) {
+    const float c = (float)(scale * std::log(10.0) / 400.0);
+    Features features[BLOCK];
+    float eval[BLOCK], target[BLOCK], score[BLOCK], slope[BLOCK];
+
+    for (size_t base = 0; base < span.count; base += BLOCK) {
+        int n = (int)std::min<size_t>(BLOCK, span.count - base);
+        for (int i = 0; i < n; ++i) {
+            const PackedPosition& p = span.records[base + i];
+            decode(p, features[i]);
+            float sum = 0;
+            for (int k = 0; k < features[i].count; ++k) sum += features[i].sign[k] * weights[features[i].index[k]];
+            eval[i] = sum;
+            score[i] = p.score;
+            target[i] = p.result * 0.5f;
+        }
+
+        double blockLoss = 0;
+        for (int i = 0; i < n; ++i) {
+            float s = 1.0f / (1.0f + std::exp(-c * eval[i]));
+            float searched = 1.0f / (1.0f + std::exp(-c * score[i]));
+            float t = (float)lambda * target[i] + (1.0f - (float)lambda) * searched;
+            float error = s - t;
+            blockLoss += error * error;
+            slope[i] = error * s * (1.0f - s);
+        }
+        pass.loss += blockLoss;
+
+        if (!withGradient) continue;
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < features[i].count; ++k) {
+                pass.gradient[features[i].index[k]] += features[i].sign[k] * slope[i];
+            }
+        }
+    }
+}
+
+// Mean squared error over all spans on 'threads' threads; fills 'gradient'
+// (d loss / d weight) when it is not null
+double evaluate(const std::vector<Span>& spans, size_t total, const std::vector<float>& weights, double lambda,
+                double scale, int threads, std::vector<double>* gradient) {
+    std::vector<Pass> passes(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            Pass& pass = passes[t];
+            if (gradient) pass.gradient.assign(WEIGHT_COUNT, 0.0);
+            // Every thread takes the same share of every file
+            for (const Span& span : spans) {
+                size_t first = span.count * t / threads;
+                size_t last = span.count * (t + 1) / threads;
+                evaluateSpan({span.records + first, last - first}, weights.data(), lambda, scale, gradient != nullptr, pass);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    double loss = 0;
+    for (const Pass& pass : passes) loss += pass.loss;
+    if (gradient) {
+        gradient->assign(WEIGHT_COUNT, 0.0);
+        double factor = 2.0 * scale * std::log(10.0) / 400.0 / (double)total;
+        for (const Pass& pass : passes) {
+            for (int w = 0; w < WEIGHT_COUNT; ++w) (*gradient)[w] += pass.gradient[w] * factor;
+        }
+    }
+    return loss / (double)total;
+}
+
+// Result of an EPD line from its c9 operation ("1-0") or, without one, a
+// trailing [1.0]; -1 if there is neither
+int parseResult(std::string_view line, const EPDPosition& position) {
+    if (!position.result.empty()) {
+        if (position.result == "1-0") return 2;
+        if (position.result == "1/2-1/2") return 1;
+        if (position.result == "0-1") return 0;
+        return -1;
+    }
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
+    size_t open = line.rfind('[');
+    if (open == std::string_view::npos) return -1;
+    std::string_view value = line.substr(open);
+    if (value == "[1.0]") return 2;
+    if (value == "[0.5]") return 1;
+    if (value == "[0.0]") return 0;
+    return -1;
+}
+
+bool writeTables(const std::string& filename, const std::vector<float>& weights, size_t positions, double scale,
+                 double loss) {
+    static const char* names[7] = {"EMPTY", "PAWN", "KNIGHT", "BISHOP", "ROOK", "QUEEN", "KING"};
+    std::ofstream out(filename);
+    out << "#include \"EvalTables.h\"\n\n";
+    out << "// Tuned by --tune on " << positions << " positions (K " << std::fixed << std::setprecision(3) << scale
+        << ", loss " << std::setprecision(6) << loss << ")\n\n";
+
+    out << "const int pieceValues[7] = {0";
+    for (int type = PAWN; type < KING; ++type) out << ", " << (int)std::lround(weights[materialWeight(type)]);
+    out << ", " << pieceValues[KING] << "};\n\n";
+
+    out << "const int pieceSquareTables[7][64] = {\n    {}, // EMPTY\n";
+    for (int type = PAWN; type <= KING; ++type) {
+        out << "    { // " << names[type] << "\n";
+        for (int rank = 0; rank < 8; ++rank) {
+            out << "    ";
+            for (int file = 0; file < 8; ++file) {
+                out << std::setw(4) << (int)std::lround(weights[tableWeight(type, rank * 8 + file)]);
+                if (rank < 7 || file < 7) out << ",";
+            }
+            out << "\n";
+        }
+        out << (type < KING ? "    },\n" : "    }\n");
+    }
+    out << "};\n";
+    return (bool)out;
+}
+
+} // namespace
+
+bool Tuner::load(const std::string& filename, std::ostream& log) {
+    auto dataset = std::make_shared<Dataset>();
+    bool epd = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".epd") == 0;
+    if (!epd) {
+        if (!dataset->file.open(filename) || dataset->file.size() % sizeof(PackedPosition) != 0) {
+            log << "Cannot read packed positions from " << filename << std::endl;
+            return false;
+        }
+        dataset->records = reinterpret_cast<const PackedPosition*>(dataset->file.data());
+        dataset->count = dataset->file.size() / sizeof(PackedPosition);
+    } else {
+        std::ifstream in(filename);
+        if (!in) {
+            log << "Cannot open " << filename << std::endl;
+            return false;
+        }
+        std::string line;
+        Board board;
+        board.setVerbose(false);
+        size_t skipped = 0;
+        while (std::getline(in, line)) {
+            EPDPosition position;
+            if (!EPDSuite::parse(line, position) || !board.setFromFEN(position.fen)) {
+                ++skipped;
+                continue;
+            }
+            int result = parseResult(line, position);
+            if (result < 0) {
+                ++skipped;
+                continue;
+            }
+            dataset->owned.push_back(PackedPosition::pack(board, 0, result));
+        }
+        if (skipped > 0) log << "Skipped " << skipped << " lines without a position or result in " << filename << std::endl;
+        dataset->records = dataset->owned.data();
+        dataset->scored = false;
+        dataset->count = dataset->owned.size();
+    }
+    log << "Loaded " << dataset->count << " positions from " << filename << std::endl;
+    datasets.push_back(std::move(dataset));
+    return true;
+}
+
+size_t Tuner::getPositionCount() const {
+    size_t total = 0;
+    for (const auto& dataset : datasets) total += dataset->count;
+    return total;
+}
+
+bool Tuner::run(const TunerOptions& options, const std::string& outputFile, std::ostream& log) {
+    size_t total = getPositionCount();
+    if (total == 0) {
+        log << "No positions to tune on" << std::endl;
+        return false;
+    }
+    // EPD records are packed with score 0, which would blend every target with 0.5
+    if (options.lambda < 1 && std::any_of(datasets.begin(), datasets.end(), [](const auto& d) { return !d->scored; })) {
+        log << "--lambda below 1 needs search scores, which EPD positions do not have" << std::endl;
+        return false;
+    }
+    int threads = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(threads, 1);
+
+    std::vector<Span> spans;
+    for (const auto& dataset : datasets) spans.push_back({dataset->records, dataset->count});
+
+    std::vector<float> weights(WEIGHT_COUNT);
+    for (int type = PAWN; type <= KING; ++type) {
+        for (int square = 0; square < 64; ++square) weights[tableWeight(type, square)] = (float)pieceSquareTables[type][square];
+        if (type != KING) weights[materialWeight(type)] = (float)pieceValues[type];
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    log << std::fixed;
+
+    // Golden-section search for the K that fits the current weights best
+    double scale = options.scale;
+    if (scale <= 0) {
+        double lo = 0.1, hi = 3.0;
+        const double ratio = (std::sqrt(5.0) - 1) / 2;
+        double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+        double la = evaluate(spans, total, weights, options.lambda, a, threads, nullptr);
+        double lb = evaluate(spans, total, weights, options.lambda, b, threads, nullptr);
+        while (hi - lo > 1e-3) {
+            if (la < lb) {
+                hi = b; b = a; lb = la;
+                a = hi - ratio * (hi - lo);
+                la = evaluate(spans, total, weights, options.lambda, a, threads, nullptr);
+            } else {
+                lo = a; a = b; la = lb;
+                b = lo + ratio * (hi - lo);
+                lb = evaluate(spans, total, weights, options.lambda, b, threads, nullptr);
+            }
+        }
+        scale = (lo + hi) / 2;
+        log << "Fitted K = " << std::setprecision(3) << scale << std::endl;
+    }
+
+    double loss = evaluate(spans, total, weights, options.lambda, scale, threads, nullptr);
+    log << "Positions: " << total << "  threads " << threads << "  initial loss " << std::setprecision(6) << loss << std::endl;
+
+    // Adam
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> gradient, m(WEIGHT_COUNT, 0.0), v(WEIGHT_COUNT, 0.0);
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        loss = evaluate(spans, total, weights, options.lambda, scale, threads, &gradient);
+        double correction1 = 1 - std::pow(beta1, epoch);
+        double correction2 = 1 - std::pow(beta2, epoch);
+        for (int w = 0; w < WEIGHT_COUNT; ++w) {
+            m[w] = beta1 * m[w] + (1 - beta1) * gradient[w];
+            v[w] = beta2 * v[w] + (1 - beta2) * gradient[w] * gradient[w];
+            weights[w] -= (float)(options.learningRate * (m[w] / correction1) / (std::sqrt(v[w] / correction2) + epsilon));
+        }
+        if (epoch % 10 == 0 || epoch == options.epochs) {
+            log << "Epoch " << std::setw(5) << epoch << "  loss " << std::setprecision(6) << loss << "  "
+                << std::setprecision(1) << elapsed() << "s" << std::endl;
+        }
+    }
+    loss = evaluate(spans, total, weights, options.lambda, scale, threads, nullptr);
+
+    log << "Final loss " << std::setprecision(6) << loss << "  material";
+    for (int type = PAWN; type < KING; ++type) log << " " << (int)std::lround(weights[materialWeight(type)]);
+    log << std::endl;
+    if (!writeTables(outputFile, weights, total, scale, loss)) {
+        log << "Cannot write " << outputFile << std::endl;
+        return false;
+    }
+    log << "Wrote " << outputFile << " (" << std::setprecision(1) << elapsed() << "s)" << std::endl;
+    return true;
+}
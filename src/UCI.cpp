@@ -2,133 +2,364 @@
 #include "Utils.h"
 #include "PGNLoader.h"
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 #include <sstream>
 #include <vector>
 
-void UCI::loop() {
-    std::string line;
-    std::string token;
-
+UCI::UCI(std::ostream& out) : out(out), sharedHash(false), sharedCache(false), background(false),
+      ownBook(false), bookDepth(20), bookBestMove(false), multiPV(1), ponder(false) {
     // Disable board verbose logging for UCI
     board.setVerbose(false);
+    search.setOutput(out);
+    mateSearch.setOutput(out);
+}
+
+UCI::~UCI() {
+    stop();
+    waitForSearch();
+}
+
+void UCI::waitForSearch() {
+    if (!searchThread.joinable()) return;
+    searchThread.join();
+    clearStop();
+}
 
+void UCI::shareTranspositionTable(std::shared_ptr<TranspositionTable> table) {
+    search.setTranspositionTable(std::move(table));
+    sharedHash = true;
+}
+
+void UCI::shareAnalysisCache(std::shared_ptr<AnalysisCache> cache) {
+    search.setAnalysisCache(std::move(cache));
+    sharedCache = true;
+}
+
+void UCI::loop() {
+    background = true;
+    std::string line;
     while (std::getline(std::cin, line)) {
-        line = trim(line);
-        if (line.empty()) continue;
+        if (!handleCommand(line)) break;
+    }
+    stop();
+    waitForSearch();
+    background = false;
+}
 
-        std::istringstream ss(line);
-        ss >> token;
+bool UCI::handleCommand(const std::string& input) {
+    std::string line = trim(input);
+    if (line.empty()) return true;
 
-        if (token == "uci") {
-            std::cout << "id name Octant 0.1" << std::endl;
-            std::cout << "id author Stumbles" << std::endl;
-            std::cout << "uciok" << std::endl;
-        }
-        else if (token == "isready") {
-            std::cout << "readyok" << std::endl;
+    std::istringstream ss(line);
+    std::string token;
+    ss >> token;
+
+    if (token == "stop" || token == "quit") {
+        if (searchThread.joinable()) {
+            stop();
         }
-        else if (token == "ucinewgame") {
-            board.setupStandardPosition();
+        waitForSearch();
+        return token != "quit";
+    }
+    // The expected move was played: the ponder search goes on as a normal one
+    if (token == "ponderhit") {
+        search.ponderhit();
+        return true;
+    }
+    // Everything except isready waits for a background search to finish
+    if (token != "isready") waitForSearch();
+
+    if (token == "uci") {
+        out << "id name Octant 0.1" << std::endl;
+        out << "id author Stumbles" << std::endl;
+        out << "option name Hash type spin default 16 min 1 max 4096" << std::endl;
+        out << "option name MultiPV type spin default 1 min 1 max 64" << std::endl;
+        out << "option name Ponder type check default false" << std::endl;
+        out << "option name TraceFile type string default <empty>" << std::endl;
+        out << "option name AnalysisFile type string default <empty>" << std::endl;
+        out << "option name TablebasePath type string default <empty>" << std::endl;
+        out << "option name OwnBook type check default false" << std::endl;
+        out << "option name BookFile type string default <empty>" << std::endl;
+        out << "option name BookDepth type spin default 20 min 1 max 200" << std::endl;
+        out << "option name BookBestMove type check default false" << std::endl;
+        out << "uciok" << std::endl;
+    }
+    else if (token == "isready") {
+        out << "readyok" << std::endl;
+    }
+    else if (token == "ucinewgame") {
+        board.setupStandardPosition();
+        positionBase.clear();
+        if (!sharedHash) search.getTranspositionTable()->clear();
+    }
+    else if (token == "position") {
+        handlePosition(line);
+    }
+    else if (token == "go") {
+        handleGo(line);
+    }
+    else if (token == "setoption") {
+        handleSetOption(line);
+    }
+    else if (token == "print") {
+        board.printBoard(out);
+    }
+    else if (token == "stats") {
+        search.getStats().print(out);
+    }
+    return true;
+}
+
+void UCI::handlePosition(const std::string& line) {
+    // Format: position startpos [moves e2e4 d7d5 ...]
+    // Format: position fen <fen_string> [moves ...]
+    std::string_view view(line);
+    size_t baseStart = view.find_first_not_of(' ', 8); // After "position"
+    if (baseStart == std::string_view::npos) return;
+
+    size_t movesPos = view.find(" moves", baseStart);
+    std::string_view base = view.substr(baseStart, movesPos == std::string_view::npos ? std::string_view::npos : movesPos - baseStart);
+    std::string_view moves;
+    if (movesPos != std::string_view::npos) {
+        size_t movesStart = view.find_first_not_of(' ', movesPos + 6);
+        if (movesStart != std::string_view::npos) moves = view.substr(movesStart);
+    }
+    while (!base.empty() && base.back() == ' ') base.remove_suffix(1);
+
+    if (base == positionBase) {
+        std::string_view applied(appliedMoves);
+
+        // Same game with more moves: apply only the new suffix
+        if (moves.substr(0, applied.size()) == applied &&
+            (moves.size() == applied.size() || applied.empty() || moves[applied.size()] == ' ')) {
+            applyMoves(moves.substr(applied.size()));
+            return;
         }
-        else if (token == "position") {
-            handlePosition(line);
+
+        // Takeback: the new list is a prefix of the applied one
+        if (applied.substr(0, moves.size()) == moves && (moves.empty() || applied[moves.size()] == ' ')) {
+            size_t keep = 0;
+            for (size_t i = 0; i < moves.size(); ++i) {
+                if (moves[i] != ' ' && (i == 0 || moves[i - 1] == ' ')) ++keep;
+            }
+            while (appliedMoveList.size() > keep) {
+                board.unmakeMove(appliedMoveList.back());
+                appliedMoveList.pop_back();
+            }
+            appliedMoves.resize(moves.size());
+            return;
         }
-        else if (token == "go") {
-            handleGo(line);
+    }
+
+    // New game or a different history: reset the board
+    if (base == "startpos") {
+        board.setupStandardPosition();
+    } else if (base.substr(0, 4) == "fen ") {
+        if (!board.setFromFEN(base.substr(4))) {
+            out << "info string invalid fen" << std::endl;
+            positionBase.clear();
+            return;
         }
-        else if (token == "quit") {
-            break;
+    } else {
+        return;
+    }
+    positionBase = base;
+    appliedMoves.clear();
+    appliedMoveList.clear();
+    applyMoves(moves);
+}
+
+bool UCI::applyMoves(std::string_view moves) {
+    size_t pos = 0;
+    while (pos < moves.size()) {
+        size_t start = moves.find_first_not_of(' ', pos);
+        if (start == std::string_view::npos) break;
+        size_t end = moves.find(' ', start);
+        if (end == std::string_view::npos) end = moves.size();
+        std::string_view token = moves.substr(start, end - start);
+        pos = end;
+
+        // UCI uses long algebraic (e2e4, e7e8q)
+        Move move = board.parseUciMove(token);
+        if (move.from == -1 || !board.makeMove(move)) {
+            out << "info string illegal move " << token << std::endl;
+            return false;
         }
-        else if (token == "print") {
-            board.printBoard();
+
+        if (!appliedMoves.empty()) appliedMoves += ' ';
+        appliedMoves.append(token);
+        appliedMoveList.push_back(move);
+    }
+    return true;
+}
+
+void UCI::handleGo(const std::string& line) {
+    // Format: go [ponder] [depth N] [movetime ms] [nodes N] [mate N] [infinite]
+    //            [wtime ms btime ms [winc ms binc ms] [movestogo N]]
+    // Plain "go" searches to depth 4.
+    SearchLimits limits;
+    limits.multiPV = multiPV;
+    bool depthGiven = false;
+    bool infinite = false;
+    int64_t clock[2] = {-1, -1}; // White, Black
+    int64_t increment[2] = {0, 0};
+    int64_t movesToGo = 0;
+    int mateMoves = 0;
+
+    std::istringstream ss(line);
+    std::string token;
+    ss >> token; // "go"
+    while (ss >> token) {
+        if (token == "depth") { ss >> limits.depth; depthGiven = true; }
+        else if (token == "movetime") ss >> limits.movetime;
+        else if (token == "nodes") ss >> limits.nodes;
+        else if (token == "infinite") { limits.depth = SearchLimits::MAX_DEPTH; depthGiven = infinite = true; }
+        else if (token == "wtime") ss >> clock[0];
+        else if (token == "btime") ss >> clock[1];
+        else if (token == "winc") ss >> increment[0];
+        else if (token == "binc") ss >> increment[1];
+        else if (token == "movestogo") ss >> movesToGo;
+        else if (token == "mate") ss >> mateMoves;
+        else if (token == "ponder") limits.ponder = true;
+    }
+    // Only a background search can receive ponderhit; otherwise search normally
+    if (!background) limits.ponder = false;
+
+    // Book moves are played without searching (not while analysing or pondering)
+    if (ownBook && !infinite && !limits.ponder && board.getFullMoveNumber() <= bookDepth) {
+        Move move = book.isOpen() ? book.probe(board, bookBestMove) : explorerBook.bookMove(board, bookBestMove);
+        if (move.from != -1) {
+            out << "info string book move" << std::endl;
+            out << "bestmove " << moveToUci(move) << std::endl;
+            return;
         }
     }
+
+    // Spend a fixed share of the remaining clock, never all of it
+    int side = board.getTurn() == WHITE ? 0 : 1;
+    if (limits.movetime == 0 && clock[side] >= 0) {
+        int64_t share = clock[side] / (movesToGo > 0 ? movesToGo : 30) + increment[side] / 2;
+        limits.movetime = std::max<int64_t>(1, std::min(share, clock[side] - 50));
+    }
+    if (!depthGiven && (limits.movetime > 0 || limits.nodes > 0)) limits.depth = SearchLimits::MAX_DEPTH;
+
+    if (background) {
+        // Before the thread exists, so an immediate ponderhit is not lost
+        if (limits.ponder) search.startPondering();
+        searchThread = std::thread(&UCI::runSearch, this, limits, mateMoves);
+    } else {
+        runSearch(limits, mateMoves);
+    }
 }
 
-void UCI::handlePosition(const std::string& line) {
-    // Format: position startpos [moves e2e4 d7d5 ...]
-    // Format: position fen <fen_string> [moves ...] (FEN not implemented yet)
-    
-    std::vector<std::string> tokens = split(line, ' ');
-    size_t movesIndex = 0;
+void UCI::runSearch(const SearchLimits& limits, int mateMoves) {
+    auto printBestMove = [&](const Move& bestMove, const std::vector<Move>& pv) {
+        out << "bestmove " << moveToUci(bestMove);
+        if (ponder && pv.size() >= 2 && moveToUci(pv[0]) == moveToUci(bestMove)) out << " ponder " << moveToUci(pv[1]);
+        out << std::endl;
+    };
 
-    // Reset board first
-    if (tokens.size() > 1 && tokens[1] == "startpos") {
-        board.setupStandardPosition();
-        movesIndex = 2;
-    } 
-    // TODO: Handle 'fen'
-
-    // Find "moves" keyword
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        if (tokens[i] == "moves") {
-            movesIndex = i + 1;
-            break;
-        }
-    }
-
-    // Apply moves
-    if (movesIndex > 0 && movesIndex < tokens.size()) {
-        for (size_t i = movesIndex; i < tokens.size(); ++i) {
-            std::string moveStr = tokens[i];
-            // UCI uses long algebraic (e2e4, e7e8q)
-            // Our parseSquare handles e2e4.
-            // We need to handle promotion suffix.
-            
-            if (moveStr.length() < 4) continue;
-            
-            int from = parseSquare(moveStr.substr(0, 2));
-            int to = parseSquare(moveStr.substr(2, 2));
-            
-            if (from == -1 || to == -1) continue;
-
-            // Find the legal move that matches
-            std::vector<Move> legalMoves = board.generateLegalMoves();
-            bool found = false;
-            for (const auto& m : legalMoves) {
-                if (m.from == from && m.to == to) {
-                    // Check promotion
-                    if (m.isPromotion) {
-                        // UCI promotion is 5th char: e7e8q
-                        char promoChar = 'q'; // default
-                        if (moveStr.length() > 4) promoChar = moveStr[4];
-                        
-                        int promoType = QUEEN;
-                        if (promoChar == 'r') promoType = ROOK;
-                        else if (promoChar == 'b') promoType = BISHOP;
-                        else if (promoChar == 'n') promoType = KNIGHT;
-                        
-                        if (m.promotionPiece == promoType) {
-                            board.makeMove(m);
-                            found = true;
-                            break;
-                        }
-                    } else {
-                        board.makeMove(m);
-                        found = true;
-                        break;
-                    }
-                }
-            }
+    // "go mate N" tries the mate solver first and falls back to a search
+    if (mateMoves > 0 && !limits.ponder) {
+        MateResult result;
+        if (mateSearch.solve(board, mateMoves, limits, result) && !result.pv.empty()) {
+            printBestMove(result.pv[0], result.pv);
+            return;
         }
+        out << "info string no mate in " << mateMoves << " found" << std::endl;
     }
+
+    // The expected reply is the second move of the last best line
+    std::vector<Move> pv;
+    search.setInfoCallback([&](const SearchInfo& info) {
+        if (info.multipv == 1) pv = info.pv;
+    });
+    Move bestMove = search.findBestMove(board, limits);
+    search.setInfoCallback(nullptr);
+    // A ponder search never answers before ponderhit or stop
+    if (limits.ponder) search.waitForPonderhit();
+    printBestMove(bestMove, pv);
 }
 
-void UCI::handleGo(const std::string& line) {
-    // Format: go wtime 300000 btime 300000 ...
-    // For now, just fixed depth
-    
-    Move bestMove = search.findBestMove(board, 4);
-    
-    std::string moveStr = squareToString(bestMove.from) + squareToString(bestMove.to);
-    if (bestMove.isPromotion) {
-        switch (bestMove.promotionPiece) {
-            case QUEEN: moveStr += "q"; break;
-            case ROOK: moveStr += "r"; break;
-            case BISHOP: moveStr += "b"; break;
-            case KNIGHT: moveStr += "n"; break;
-        }
-    }
-    
-    std::cout << "bestmove " << moveStr << std::endl;
+void UCI::handleSetOption(const std::string& line) {
+    // Format: setoption name <id> [value <x>]
+    size_t namePos = line.find(" name ");
+    if (namePos == std::string::npos) return;
+    size_t valuePos = line.find(" value ", namePos);
+
+    std::string name = trim(line.substr(namePos + 6, valuePos == std::string::npos ? std::string::npos : valuePos - namePos - 6));
+    std::string value = valuePos == std::string::npos ? "" : trim(line.substr(valuePos + 7));
+
+    if (name == "Hash") {
+        if (sharedHash) {
+            out << "info string Hash is shared and fixed by the daemon" << std::endl;
+            return;
+        }
+        int megabytes = std::atoi(value.c_str());
+        if (megabytes < 1 || megabytes > 4096) {
+            out << "info string Hash must be between 1 and 4096" << std::endl;
+            return;
+        }
+        search.getTranspositionTable()->resize((size_t)megabytes);
+    }
+    else if (name == "AnalysisFile") {
+        if (sharedCache) {
+            out << "info string AnalysisFile is fixed by --cache" << std::endl;
+            return;
+        }
+        if (value == "<empty>" || value.empty()) {
+            search.setAnalysisCache(nullptr);
+            return;
+        }
+        auto cache = std::make_shared<AnalysisCache>();
+        if (!cache->open(value)) {
+            out << "info string cannot open analysis file " << value << std::endl;
+            return;
+        }
+        search.setAnalysisCache(std::move(cache));
+    }
+    else if (name == "MultiPV") {
+        multiPV = std::clamp(std::atoi(value.c_str()), 1, 64);
+    }
+    else if (name == "Ponder") {
+        ponder = value == "true";
+    }
+    else if (name == "TablebasePath") {
+        if (value == "<empty>" || value.empty()) {
+            search.setTablebases(nullptr);
+            return;
+        }
+        auto tables = std::make_shared<Tablebases>();
+        if (!tables->open(value)) {
+            out << "info string no tablebases in " << value << std::endl;
+            search.setTablebases(nullptr);
+            return;
+        }
+        out << "info string loaded " << tables->getTableCount() << " tablebases" << std::endl;
+        search.setTablebases(std::move(tables));
+    }
+    else if (name == "OwnBook") {
+        ownBook = value == "true";
+    }
+    else if (name == "BookFile") {
+        book.close();
+        explorerBook.close();
+        if (value == "<empty>" || value.empty() || explorerBook.open(value)) return;
+        if (!book.open(value)) {
+            out << "info string cannot open book " << value << std::endl;
+        }
+    }
+    else if (name == "BookDepth") {
+        bookDepth = std::max(1, std::atoi(value.c_str()));
+    }
+    else if (name == "BookBestMove") {
+        bookBestMove = value == "true";
+    }
+    else if (name == "TraceFile") {
+        if (value == "<empty>") value.clear();
+        if (!search.setTraceFile(value)) {
+            out << "info string cannot open trace file " << value << std::endl;
+        }
+    }
 }
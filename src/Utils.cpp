@@ -17,6 +17,13 @@ std::string squareToString(int square) {
     return std::string(1, 'a' + file) + std::to_string(rank + 1);
 }
 
+std::string moveToUci(const Move& move) {
+    if (move.from == -1) return "0000";
+    std::string s = squareToString(move.from) + squareToString(move.to);
+    if (move.isPromotion) s += " pnbrqk"[move.promotionPiece];
+    return s;
+}
+
 std::vector<std::string> split(const std::string& s, char delimiter) {
     std::vector<std::string> tokens;
     std::string token;
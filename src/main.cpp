@@ -1,12 +1,24 @@
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <iomanip>
+#include <fstream>
+#include <cctype>
 #include "Board.h"
 #include "Search.h"
 #include "Utils.h"
 #include "PGNLoader.h"
 #include "UCI.h"
+#include "Benchmark.h"
+#include "Daemon.h"
+#include "DataGen.h"
+#include "EPDSuite.h"
+#include "Match.h"
+#include "OpeningExplorer.h"
+#include "PolyglotBook.h"
+#include "Tablebase.h"
+#include "Tuner.h"
 
 void drawEvalBar(int score) {
     const int width = 40; // Total width of the bar
@@ -41,7 +53,39 @@ int main(int argc, char* argv[]) {
     bool verbose = false;
     bool playComputer = false;
     bool uciMode = false;
+    bool daemonMode = false;
+    DaemonOptions daemonOptions;
     std::string pgnFile;
+    int perftDepth = 0;
+    int benchDepth = 0;
+    int schedBenchGames = 0;
+    std::string perfJsonFile;
+    std::string pgnBenchFile;
+    std::string evalBenchFile;
+    std::string fen;
+    std::string bookFile;
+    std::string explorerBuild;          // Index to build from explorerPGNs
+    std::vector<std::string> explorerPGNs;
+    std::string explorerIndex;          // Index to query
+    std::string explorerMoves;
+    std::string epdFile;
+    std::string epdJsonFile;
+    SearchLimits limits;                // --depth, --movetime, --nodes for --epd and --match
+    bool depthGiven = false;
+    bool matchMode = false;
+    MatchOptions matchOptions;
+    std::string openingsFile;
+    std::string engineSpecs[2];
+    std::string dataFile;               // --datagen output
+    std::string shuffleFile;
+    DataGenOptions dataOptions;
+    std::vector<std::string> tuneFiles;
+    std::string tuneOutput = "EvalTables.cpp";
+    TunerOptions tunerOptions;
+    std::string tablebaseDir;           // --tb-generate output
+    std::vector<std::string> tablebaseNames;
+    std::string probeDir;               // --tb-probe tables
+    bool pgnReplay = false;
     int computerColor = BLACK; // Default computer plays Black
     
     for (int i = 1; i < argc; ++i) {
@@ -59,10 +103,344 @@ int main(int argc, char* argv[]) {
             pgnFile = argv[i + 1];
             i++; // Skip next arg
         }
+        if (arg == "--perft" && i + 1 < argc) {
+            perftDepth = std::stoi(argv[++i]);
+        }
+        if (arg == "--bench") {
+            benchDepth = 4;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) benchDepth = std::stoi(argv[++i]);
+        }
+        if (arg == "--sched-bench") {
+            schedBenchGames = 200;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) schedBenchGames = std::stoi(argv[++i]);
+        }
+        if (arg == "--fen" && i + 1 < argc) {
+            fen = argv[++i];
+        }
+        if (arg == "--pgn-bench" && i + 1 < argc) {
+            pgnBenchFile = argv[++i];
+        }
+        if (arg == "--eval-bench" && i + 1 < argc) {
+            evalBenchFile = argv[++i];
+        }
+        if (arg == "--replay") {
+            pgnReplay = true;
+        }
+        if (arg == "--perf-json" && i + 1 < argc) {
+            perfJsonFile = argv[++i];
+        }
+        if (arg == "--daemon") {
+            daemonMode = true;
+        }
+        if (arg == "--socket" && i + 1 < argc) {
+            daemonOptions.socketPath = argv[++i];
+        }
+        if (arg == "--workers" && i + 1 < argc) {
+            daemonOptions.workers = std::stoi(argv[++i]);
+        }
+        if (arg == "--hash" && i + 1 < argc) {
+            daemonOptions.hashMB = (size_t)std::stoi(argv[++i]);
+        }
+        if (arg == "--queue" && i + 1 < argc) {
+            daemonOptions.queueLimit = (size_t)std::stoi(argv[++i]);
+        }
+        if (arg == "--build-explorer" && i + 1 < argc) {
+            explorerBuild = argv[++i];
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                explorerPGNs.push_back(argv[++i]);
+            }
+        }
+        if (arg == "--explore" && i + 1 < argc) {
+            explorerIndex = argv[++i];
+        }
+        if (arg == "--moves" && i + 1 < argc) {
+            explorerMoves = argv[++i];
+        }
+        if (arg == "--book" && i + 1 < argc) {
+            bookFile = argv[++i];
+        }
+        if (arg == "--cache" && i + 1 < argc) {
+            daemonOptions.cacheFile = argv[++i];
+        }
+        if (arg == "--cache-size" && i + 1 < argc) {
+            daemonOptions.cacheMB = (size_t)std::stoi(argv[++i]);
+        }
+        if (arg == "--epd" && i + 1 < argc) {
+            epdFile = argv[++i];
+        }
+        if (arg == "--epd-json" && i + 1 < argc) {
+            epdJsonFile = argv[++i];
+        }
+        if (arg == "--depth" && i + 1 < argc) {
+            limits.depth = std::stoi(argv[++i]);
+            depthGiven = true;
+        }
+        if (arg == "--movetime" && i + 1 < argc) {
+            limits.movetime = std::stoi(argv[++i]);
+        }
+        if (arg == "--nodes" && i + 1 < argc) {
+            limits.nodes = std::stoull(argv[++i]);
+        }
+        if (arg == "--datagen" && i + 1 < argc) {
+            dataFile = argv[++i];
+        }
+        if (arg == "--positions" && i + 1 < argc) {
+            dataOptions.positions = std::stoull(argv[++i]);
+        }
+        if (arg == "--random-plies" && i + 1 < argc) {
+            dataOptions.randomPlies = std::stoi(argv[++i]);
+        }
+        if (arg == "--seed" && i + 1 < argc) {
+            dataOptions.seed = std::stoull(argv[++i]);
+        }
+        if (arg == "--shuffle" && i + 1 < argc) {
+            shuffleFile = argv[++i];
+        }
+        if (arg == "--tune") {
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                tuneFiles.push_back(argv[++i]);
+            }
+        }
+        if (arg == "--tune-out" && i + 1 < argc) {
+            tuneOutput = argv[++i];
+        }
+        if (arg == "--epochs" && i + 1 < argc) {
+            tunerOptions.epochs = std::stoi(argv[++i]);
+        }
+        if (arg == "--learning-rate" && i + 1 < argc) {
+            tunerOptions.learningRate = std::stod(argv[++i]);
+        }
+        if (arg == "--lambda" && i + 1 < argc) {
+            tunerOptions.lambda = std::stod(argv[++i]);
+        }
+        if (arg == "--scale" && i + 1 < argc) {
+            tunerOptions.scale = std::stod(argv[++i]);
+        }
+        if (arg == "--tb-generate" && i + 1 < argc) {
+            tablebaseDir = argv[++i];
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                tablebaseNames.push_back(argv[++i]);
+            }
+        }
+        if (arg == "--tb-probe" && i + 1 < argc) {
+            probeDir = argv[++i];
+        }
+        if (arg == "--match") {
+            matchMode = true;
+        }
+        if (arg == "--openings" && i + 1 < argc) {
+            openingsFile = argv[++i];
+        }
+        if (arg == "--games" && i + 1 < argc) {
+            matchOptions.games = std::stoi(argv[++i]);
+        }
+        if ((arg == "--engine-a" || arg == "--engine-b") && i + 1 < argc) {
+            engineSpecs[arg == "--engine-a" ? 0 : 1] = argv[++i];
+        }
+        if (arg == "--pgn-out" && i + 1 < argc) {
+            matchOptions.pgnFile = argv[++i];
+        }
+        if (arg == "--sprt" && i + 1 < argc) {
+            std::vector<std::string> bounds = split(argv[++i], ',');
+            matchOptions.sprt = true;
+            matchOptions.elo0 = std::stod(bounds[0]);
+            if (bounds.size() > 1) matchOptions.elo1 = std::stod(bounds[1]);
+        }
+    }
+
+    if (daemonMode) {
+        Daemon daemon(daemonOptions);
+        return daemon.run();
+    }
+
+    if (!dataFile.empty()) {
+        if (limits.nodes > 0) dataOptions.nodes = limits.nodes;
+        if (depthGiven) dataOptions.depth = limits.depth;
+        dataOptions.threads = daemonOptions.workers;
+        dataOptions.hashMB = daemonOptions.hashMB;
+        return DataGen::run(dataOptions, dataFile, std::cout) ? 0 : 1;
+    }
+
+    if (!shuffleFile.empty()) {
+        return DataGen::shuffle(shuffleFile, dataOptions.seed, std::cout) ? 0 : 1;
+    }
+
+    if (!tuneFiles.empty()) {
+        Tuner tuner;
+        for (const std::string& file : tuneFiles) {
+            if (!tuner.load(file, std::cerr)) return 1;
+        }
+        tunerOptions.threads = daemonOptions.workers;
+        return tuner.run(tunerOptions, tuneOutput, std::cout) ? 0 : 1;
+    }
+
+    if (!tablebaseDir.empty()) {
+        return Tablebases::generate(tablebaseDir, tablebaseNames, daemonOptions.workers, std::cout) ? 0 : 1;
+    }
+
+    if (!probeDir.empty()) {
+        Tablebases tables;
+        if (!tables.open(probeDir)) {
+            std::cerr << "No tablebases in " << probeDir << std::endl;
+            return 1;
+        }
+        Board board;
+        board.setVerbose(false);
+        if (!fen.empty() && !board.setFromFEN(fen)) {
+            std::cerr << "Invalid FEN: " << fen << std::endl;
+            return 1;
+        }
+        auto describe = [](const TablebaseResult& result) {
+            if (result.wdl == 0) return std::string("draw");
+            return std::string(result.wdl > 0 ? "win" : "loss") + " in " + std::to_string(result.plies) + " plies";
+        };
+        TablebaseResult result;
+        if (!tables.probe(board, result)) {
+            std::cerr << "Position not in the tablebases" << std::endl;
+            return 1;
+        }
+        std::cout << board.toFEN() << ": " << describe(result) << std::endl;
+        for (const Move& move : board.generateLegalMoves()) {
+            board.makeMove(move);
+            bool found = tables.probe(board, result);
+            board.unmakeMove(move);
+            // From the mover's point of view
+            result.wdl = -result.wdl;
+            if (result.wdl != 0) ++result.plies;
+            std::cout << "  " << moveToUci(move) << "  " << (found ? describe(result) : "not in tables") << std::endl;
+        }
+        return 0;
+    }
+
+    // Time and node limits replace the default depth unless one was given
+    if (!depthGiven && (limits.movetime > 0 || limits.nodes > 0)) limits.depth = SearchLimits::MAX_DEPTH;
+
+    if (!epdFile.empty()) {
+        EPDSuite suite;
+        if (!suite.load(epdFile, std::cerr)) return 1;
+        EPDOptions epdOptions;
+        epdOptions.limits = limits;
+        epdOptions.depthGiven = depthGiven;
+        epdOptions.threads = daemonOptions.workers;
+        epdOptions.hashMB = daemonOptions.hashMB;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<EPDResult> results = suite.run(epdOptions, std::cout);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!epdJsonFile.empty()) {
+            std::ofstream json(epdJsonFile);
+            suite.writeJSON(results, epdOptions, seconds, json);
+            if (!json) {
+                std::cerr << "Cannot write " << epdJsonFile << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    if (matchMode) {
+        const char* defaultNames[2] = {"Octant-A", "Octant-B"};
+        for (int e = 0; e < 2; ++e) {
+            MatchEngine& engine = matchOptions.engines[e];
+            engine.name = defaultNames[e];
+            engine.limits = limits;
+            engine.hashMB = daemonOptions.hashMB;
+            if (!engine.configure(engineSpecs[e])) {
+                std::cerr << "Invalid engine settings: " << engineSpecs[e] << std::endl;
+                return 1;
+            }
+        }
+        if (openingsFile.empty()) matchOptions.openings = Match::defaultOpenings();
+        else if (!Match::loadOpenings(openingsFile, matchOptions.openings, std::cerr)) return 1;
+        matchOptions.threads = daemonOptions.workers;
+        Match::run(matchOptions, std::cout);
+        return 0;
+    }
+
+    if (!explorerBuild.empty()) {
+        ExplorerBuildOptions options;
+        options.threads = daemonOptions.workers;
+        return OpeningExplorer::build(explorerPGNs, explorerBuild, options, std::cout) ? 0 : 1;
+    }
+
+    if (!explorerIndex.empty()) {
+        OpeningExplorer explorer;
+        if (!explorer.open(explorerIndex)) {
+            std::cerr << "Cannot open explorer index " << explorerIndex << std::endl;
+            return 1;
+        }
+        Board board;
+        board.setVerbose(false);
+        if (!fen.empty() && !board.setFromFEN(fen)) {
+            std::cerr << "Invalid FEN: " << fen << std::endl;
+            return 1;
+        }
+        for (const std::string& uci : split(explorerMoves, ' ')) {
+            if (uci.empty()) continue;
+            Move move = board.parseUciMove(uci);
+            if (move.from == -1 || !board.makeMove(move)) {
+                std::cerr << "Illegal move: " << uci << std::endl;
+                return 1;
+            }
+        }
+
+        std::vector<ExplorerMove> moves;
+        auto start = std::chrono::steady_clock::now();
+        explorer.query(board, moves);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        OpeningExplorer::print(board, moves, std::cout);
+        std::cout << "(" << explorer.getGameCount() << " games indexed, query " << micros << " us)" << std::endl;
+        return 0;
+    }
+
+    if (perftDepth > 0) {
+        Board board;
+        if (!fen.empty() && !board.setFromFEN(fen)) {
+            std::cerr << "Invalid FEN: " << fen << std::endl;
+            return 1;
+        }
+        Benchmark::perftDivide(board, perftDepth, std::cout);
+        return 0;
+    }
+
+    if (benchDepth > 0) {
+        Benchmark::runBench(benchDepth, std::cout);
+        return 0;
+    }
+
+    if (schedBenchGames > 0) {
+        Benchmark::runSchedulerBench(schedBenchGames, daemonOptions.workers, std::cout);
+        return 0;
+    }
+
+    if (!evalBenchFile.empty()) {
+        return Benchmark::runEvalThroughput(evalBenchFile, std::cout) ? 0 : 1;
+    }
+
+    if (!pgnBenchFile.empty()) {
+        return Benchmark::runPGNThroughput(pgnBenchFile, pgnReplay, std::cout) ? 0 : 1;
+    }
+
+    if (!perfJsonFile.empty()) {
+        std::ofstream json(perfJsonFile);
+        if (!json) {
+            std::cerr << "Cannot write " << perfJsonFile << std::endl;
+            return 1;
+        }
+        Benchmark::runPerfSuite(json);
+        return 0;
     }
 
     if (uciMode) {
         UCI uci;
+        if (!daemonOptions.cacheFile.empty()) {
+            auto cache = std::make_shared<AnalysisCache>();
+            if (!cache->open(daemonOptions.cacheFile, daemonOptions.cacheMB)) {
+                std::cerr << "Cannot open analysis cache " << daemonOptions.cacheFile << std::endl;
+                return 1;
+            }
+            uci.shareAnalysisCache(cache);
+        }
         uci.loop();
         return 0;
     }
@@ -74,6 +452,21 @@ int main(int argc, char* argv[]) {
     Board board;
     board.setVerbose(verbose);
     Search search;
+
+    if (!fen.empty() && !board.setFromFEN(fen)) {
+        std::cerr << "Invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+
+    if (!pgnFile.empty() && !PGNLoader::loadPGN(pgnFile, board)) {
+        return 1;
+    }
+
+    PolyglotBook book;
+    if (!bookFile.empty() && !book.open(bookFile)) {
+        std::cerr << "Cannot open book " << bookFile << std::endl;
+        return 1;
+    }
     
     std::string input;
     while (true) {
@@ -92,9 +485,11 @@ int main(int argc, char* argv[]) {
 
         if (playComputer && board.getTurn() == computerColor) {
             // Computer's turn
-            Move bestMove = search.findBestMove(board, 4); // Depth 4
+            Move bestMove = book.isOpen() ? book.probe(board, false) : Move();
+            if (bestMove.from == -1) bestMove = search.findBestMove(board, 4); // Depth 4
+            std::string san = PGNLoader::toSAN(bestMove, board);
             board.makeMove(bestMove);
-            std::cout << "Computer played: " << squareToString(bestMove.from) << squareToString(bestMove.to) << std::endl;
+            std::cout << "Computer played: " << san << std::endl;
             continue;
         }
 
@@ -0,0 +1,207 @@
+// Offline analysis of search traces written with "setoption name TraceFile".
+//
+//   octant-trace summary <trace> [--top N]
+//   octant-trace chrome <trace> <out.json> [--max-ply N]
+//
+// The Chrome trace uses the node counter as the time axis, so the width of
+// each slice in chrome://tracing or Perfetto is the size of its subtree.
+
+#include "SearchTrace.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string moveToString(uint16_t move) {
+    int from = move & 63;
+    int to = (move >> 6) & 63;
+    int promo = move >> 12;
+    std::string s = squareToString(from) + squareToString(to);
+    if (promo) s += " pnbrqk"[promo];
+    return s;
+}
+
+bool readTrace(const std::string& filename, std::vector<TraceEvent>& events) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return false;
+    }
+
+    TraceHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION || header.eventSize != sizeof(TraceEvent)) {
+        std::cerr << filename << " is not an Octant trace (version " << TRACE_VERSION << ")" << std::endl;
+        return false;
+    }
+
+    TraceEvent e;
+    while (file.read(reinterpret_cast<char*>(&e), sizeof(e))) events.push_back(e);
+    return true;
+}
+
+struct Subtree {
+    int iteration;
+    const TraceEvent* event;
+    std::vector<uint16_t> path;
+};
+
+int summary(const std::vector<TraceEvent>& events, int top) {
+    const int hotPly = 3;
+
+    struct IterationSummary {
+        int depth = 0;
+        uint64_t nodes = 0;
+        uint64_t cutoffs = 0;
+        uint64_t firstMoveCutoffs = 0;
+        uint64_t interior = 0;
+        int rootSearches = 0;
+        int rootResearches = 0;
+        std::map<int, uint64_t> nodesPerPly;
+        std::map<uint16_t, int> rootMoveCount;
+    };
+
+    std::vector<IterationSummary> iterations;
+    std::vector<Subtree> subtrees;
+    std::vector<std::vector<size_t>> pending(hotPly + 2);
+
+    for (const TraceEvent& e : events) {
+        if (e.type == TRACE_ITERATION) {
+            iterations.emplace_back();
+            iterations.back().depth = e.depth;
+            for (auto& p : pending) p.clear();
+            continue;
+        }
+        if (iterations.empty()) iterations.emplace_back();
+        IterationSummary& it = iterations.back();
+
+        it.nodes++;
+        it.nodesPerPly[e.ply]++;
+        if (e.depth > 0) it.interior++;
+        if (e.cutoffIndex != TRACE_NO_CUTOFF) {
+            it.cutoffs++;
+            if (e.cutoffIndex == 0) it.firstMoveCutoffs++;
+        }
+        if (e.ply == 1) {
+            it.rootSearches++;
+            if (++it.rootMoveCount[e.move] > 1) it.rootResearches++;
+        }
+
+        // Post-order: pending events one ply deeper are this node's children
+        if (e.ply >= 1 && e.ply <= hotPly) {
+            for (size_t child : pending[e.ply + 1]) {
+                subtrees[child].path.insert(subtrees[child].path.begin(), e.move);
+            }
+            pending[e.ply + 1].clear();
+            subtrees.push_back({(int)iterations.size(), &e, {e.move}});
+            pending[e.ply].push_back(subtrees.size() - 1);
+        }
+    }
+
+    std::cout << "Events: " << events.size() << "  Iterations: " << iterations.size() << std::endl;
+    for (size_t i = 0; i < iterations.size(); ++i) {
+        const IterationSummary& it = iterations[i];
+        std::cout << "\nIteration " << (i + 1) << " (depth " << it.depth << "): " << it.nodes << " nodes";
+        if (i > 0 && iterations[i - 1].nodes > 0) {
+            std::cout << ", ebf " << std::fixed << std::setprecision(2) << (double)it.nodes / iterations[i - 1].nodes;
+        }
+        std::cout << std::endl;
+        std::cout << "  root moves searched " << it.rootSearches << ", re-searched " << it.rootResearches << std::endl;
+        if (it.cutoffs > 0) {
+            std::cout << "  cutoffs " << it.cutoffs << " (" << std::fixed << std::setprecision(1)
+                      << (100.0 * it.firstMoveCutoffs / it.cutoffs) << "% on first move)" << std::endl;
+        }
+        std::cout << "  nodes per ply:";
+        for (const auto& [ply, nodes] : it.nodesPerPly) std::cout << " " << ply << ":" << nodes;
+        std::cout << std::endl;
+    }
+
+    std::sort(subtrees.begin(), subtrees.end(), [](const Subtree& a, const Subtree& b) {
+        return a.event->subtree > b.event->subtree;
+    });
+
+    std::cout << "\nHot subtrees (ply <= " << hotPly << "):" << std::endl;
+    for (int i = 0; i < top && i < (int)subtrees.size(); ++i) {
+        const Subtree& s = subtrees[i];
+        std::string path;
+        for (uint16_t m : s.path) {
+            if (!path.empty()) path += ' ';
+            path += moveToString(m);
+        }
+        std::cout << "  " << std::setw(10) << s.event->subtree << " nodes  iter " << s.iteration
+                  << "  score " << s.event->score << "  " << path << std::endl;
+    }
+    return 0;
+}
+
+int chrome(const std::vector<TraceEvent>& events, const std::string& outFile, int maxPly) {
+    std::ofstream out(outFile);
+    if (!out) {
+        std::cerr << "Cannot write " << outFile << std::endl;
+        return 1;
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    int iteration = 0;
+    for (const TraceEvent& e : events) {
+        if (e.type == TRACE_ITERATION) {
+            ++iteration;
+            out << (first ? "" : ",\n") << "{\"name\":\"iteration " << iteration << " depth " << e.depth
+                << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":" << e.node << "}";
+            first = false;
+            continue;
+        }
+        if (e.ply > maxPly) continue;
+
+        out << (first ? "" : ",\n") << "{\"name\":\"" << moveToString(e.move) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << e.node << ",\"dur\":" << e.subtree
+            << ",\"args\":{\"ply\":" << (int)e.ply << ",\"depth\":" << e.depth
+            << ",\"alpha\":" << e.alpha << ",\"beta\":" << e.beta << ",\"score\":" << e.score;
+        if (e.cutoffIndex != TRACE_NO_CUTOFF) out << ",\"cutoff\":" << e.cutoffIndex;
+        out << "}}";
+        first = false;
+    }
+    out << "\n]}" << std::endl;
+    return 0;
+}
+
+int usage() {
+    std::cerr << "Usage: octant-trace summary <trace> [--top N]" << std::endl;
+    std::cerr << "       octant-trace chrome <trace> <out.json> [--max-ply N]" << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) return usage();
+
+    std::string command = argv[1];
+    std::vector<TraceEvent> events;
+    if (!readTrace(argv[2], events)) return 1;
+
+    if (command == "summary") {
+        int top = 10;
+        for (int i = 3; i < argc; ++i) {
+            if (std::string(argv[i]) == "--top" && i + 1 < argc) top = std::stoi(argv[++i]);
+        }
+        return summary(events, top);
+    }
+    if (command == "chrome" && argc >= 4) {
+        int maxPly = 4;
+        for (int i = 4; i < argc; ++i) {
+            if (std::string(argv[i]) == "--max-ply" && i + 1 < argc) maxPly = std::stoi(argv[++i]);
+        }
+        return chrome(events, argv[3], maxPly);
+    }
+    return usage();
+}